@@ -0,0 +1,66 @@
+//------------------------------------------------------------------------------
+// BatchMatcher.h
+// agent
+// 17 October 2026
+// Matches many input strings at once, spread over a WorkStealingPool
+//------------------------------------------------------------------------------
+#ifndef BATCHMATCHER_H
+#define BATCHMATCHER_H
+#include <algorithm>
+#include <string_view>
+#include "WorkStealingPool.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// Chunks handed to the pool carry at least this many input bytes, so that
+// scheduling costs stay small next to the matching itself.
+//------------------------------------------------------------------------------
+const size_t MIN_BATCH_CHUNK_BYTES = 64 * 1024;
+
+//------------------------------------------------------------------------------
+// Aim for this many chunks per worker so stealing can even out the load.
+//------------------------------------------------------------------------------
+const size_t BATCH_CHUNKS_PER_WORKER = 8;
+
+//------------------------------------------------------------------------------
+// matchBatch(const Matcher& matcher, const string_view* inputs, size_t count,
+// bool* results, WorkStealingPool& pool)
+// Sets results[i] to matcher.checkString(inputs[i]) for every i < count.
+// Matcher is any class with a MatchContext and a const
+// checkString(string_view, MatchContext&), such as CompiledDfa or
+// CompiledNfaEpsilon; it is shared read-only by every worker, and each chunk
+// reuses one MatchContext for all of its inputs.
+// The chunk size is picked so each chunk holds roughly MIN_BATCH_CHUNK_BYTES
+// of input, but small enough to give each worker BATCH_CHUNKS_PER_WORKER
+// chunks when the batch is large.
+//------------------------------------------------------------------------------
+template<class Matcher>
+void matchBatch(const Matcher& matcher, const string_view* inputs,
+   size_t count, bool* results, WorkStealingPool& pool)
+{
+   if(count == 0)
+   {
+      return;
+   }
+   size_t totalBytes = 0;
+   for(size_t i = 0; i < count; ++i)
+   {
+      totalBytes += inputs[i].size();
+   }
+   size_t averageBytes = max<size_t>(1, totalBytes / count);
+   size_t byteGrain = (MIN_BATCH_CHUNK_BYTES + averageBytes - 1) / averageBytes;
+   size_t balanceGrain = count / (pool.size() * BATCH_CHUNKS_PER_WORKER);
+   size_t grain = max<size_t>(1, min(byteGrain, max<size_t>(1, balanceGrain)));
+
+   pool.parallelFor(count, grain, [&](size_t begin, size_t end)
+   {
+      typename Matcher::MatchContext context;
+      for(size_t i = begin; i < end; ++i)
+      {
+         results[i] = matcher.checkString(inputs[i], context);
+      }
+   });
+}
+
+#endif // BATCHMATCHER_H
@@ -0,0 +1,402 @@
+//------------------------------------------------------------------------------
+// Benchmark.cpp
+// agent
+// 17 October 2026
+// Benchmark driver for FiniteAutomata project.
+// Times the four regular expression processors exercised by main.cpp, and
+// the JIT, on generated machines and prints the results as JSON, so that
+// runs can be compared by a script:
+// NFA-EPSILON                       - engine "nfa_epsilon"
+// DFA passed to CompiledDfa as is   - engine "dfa"
+// DFA from translateToDFA(nfae)     - engine "translate_argument"
+// DFA from translateToDFA()         - engine "translate_member"
+// DFA run as JIT generated code     - engine "jit"
+// The generated machines are:
+//    random_dfa     - n nodes, each with a transition to a random node on
+//                     every char of a 4 char alphabet, half of them goals
+//    pathological   - the NFA-EPSILON for (a?)^n a^n, the classic worst
+//                     case for backtracking matchers
+//    rule_union     - n random 8 char words joined under one start node by
+//                     EPSILON transitions, as a rule set would be
+// "dfa" and "jit" only run on random_dfa, the one machine already in DFA
+// format, and "nfa_epsilon" is skipped on machines over MAX_NFA_NODES nodes,
+// whose bit parallel tables would not fit in memory.
+// For each machine and engine the output reports:
+//    compile_ms       - time to build the engine, translation included
+//    ns_per_byte      - matching time per input byte
+//    matches_per_sec  - checkString() calls per second
+//    accepted         - number of inputs accepted, equal for every engine
+//    peak_rss_kb      - peak resident memory while compiling and matching
+//    added_rss_kb     - peak_rss_kb less the resident memory before
+//                       compiling, i.e. what the engine itself needed
+// Options:
+//    --quick          - smaller machines and inputs, for a smoke test
+//    --bytes=N        - input bytes matched per engine (default 16 MiB)
+//    --seed=N         - seed of the generators (default 1)
+//------------------------------------------------------------------------------
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "CompiledDfa.h"
+#include "CompiledNfaEpsilon.h"
+#include "JitDfa.h"
+
+using namespace std;
+
+//Largest machine the nfa_epsilon engine is run on
+static const int MAX_NFA_NODES = 10000;
+//Length of the words of a rule_union
+static const int RULE_LENGTH = 8;
+
+//------------------------------------------------------------------------------
+// struct Workload
+// A generated machine, whether it is in DFA format, and the inputs matched
+// against it.
+//------------------------------------------------------------------------------
+struct Workload
+{
+   string machine;
+   int parameter;
+   FiniteStateMachine fsm;
+   bool isDfa;
+   vector<string> inputs;
+   size_t inputBytes;
+};
+
+//------------------------------------------------------------------------------
+// randomDfa(int nodeCount, mt19937& random)
+// Every node gets one transition on each of 'a' .. 'd' to a uniformly random
+// node and is a goal node with probability 1/2.
+//------------------------------------------------------------------------------
+static FiniteStateMachine randomDfa(int nodeCount, mt19937& random)
+{
+   FiniteStateMachine dfa;
+   uniform_int_distribution<int> anyNode(0, nodeCount - 1);
+   dfa.startNode = 0;
+   for(int node = 0; node < nodeCount; ++node)
+   {
+      dfa.nodes.emplace(node);
+      if(random() & 1)
+      {
+         dfa.goalNodes.emplace(node);
+      }
+      for(char symbol = 'a'; symbol <= 'd'; ++symbol)
+      {
+         dfa.transitions.emplace_back(node, symbol, anyNode(random));
+      }
+   }
+   return dfa;
+}
+
+//------------------------------------------------------------------------------
+// pathologicalNfa(int n)
+// (a?)^n a^n: nodes 0 .. n - 1 each step to the next node on 'a' or EPSILON,
+// nodes n .. 2n - 1 only on 'a', and node 2n is the goal node.  Accepts
+// between n and 2n a's.
+//------------------------------------------------------------------------------
+static FiniteStateMachine pathologicalNfa(int n)
+{
+   FiniteStateMachine nfae;
+   nfae.startNode = 0;
+   for(int node = 0; node <= 2 * n; ++node)
+   {
+      nfae.nodes.emplace(node);
+   }
+   nfae.goalNodes.emplace(2 * n);
+   for(int node = 0; node < 2 * n; ++node)
+   {
+      nfae.transitions.emplace_back(node, 'a', node + 1);
+      if(node < n)
+      {
+         nfae.transitions.emplace_back(node, EPSILON, node + 1);
+      }
+   }
+   return nfae;
+}
+
+//------------------------------------------------------------------------------
+// ruleUnion(int ruleCount, mt19937& random, vector<string>& words)
+// Node 0 has an EPSILON transition to the first node of a chain of
+// RULE_LENGTH transitions per rule, spelling a random word over 'a' .. 'p';
+// the last node of every chain is a goal node.  The words are returned in
+// words.
+//------------------------------------------------------------------------------
+static FiniteStateMachine ruleUnion(int ruleCount, mt19937& random,
+   vector<string>& words)
+{
+   FiniteStateMachine nfae;
+   uniform_int_distribution<int> anyChar('a', 'p');
+   nfae.startNode = 0;
+   nfae.nodes.emplace(0);
+   int nextNode = 1;
+   for(int rule = 0; rule < ruleCount; ++rule)
+   {
+      string word;
+      nfae.transitions.emplace_back(0, EPSILON, nextNode);
+      for(int pos = 0; pos < RULE_LENGTH; ++pos)
+      {
+         char symbol = static_cast<char>(anyChar(random));
+         word += symbol;
+         nfae.nodes.emplace(nextNode);
+         nfae.transitions.emplace_back(nextNode, symbol, nextNode + 1);
+         ++nextNode;
+      }
+      nfae.nodes.emplace(nextNode);
+      nfae.goalNodes.emplace(nextNode);
+      ++nextNode;
+      words.push_back(word);
+   }
+   return nfae;
+}
+
+//------------------------------------------------------------------------------
+// fillInputs(Workload& workload, size_t totalBytes,
+// const function<string()>& makeInput)
+// Appends inputs made by makeInput until they add up to totalBytes.
+//------------------------------------------------------------------------------
+static void fillInputs(Workload& workload, size_t totalBytes,
+   const function<string()>& makeInput)
+{
+   workload.inputBytes = 0;
+   while(workload.inputBytes < totalBytes)
+   {
+      workload.inputs.push_back(makeInput());
+      workload.inputBytes += workload.inputs.back().size();
+   }
+}
+
+//------------------------------------------------------------------------------
+// makeWorkloads(bool quick, size_t totalBytes, unsigned seed)
+// Generates every machine along with its inputs:
+//    random_dfa   - random 64 char strings over 'a' .. 'd'
+//    pathological - runs of between 0 and 3n a's
+//    rule_union   - half of them one of the words, the rest 8 random chars
+//------------------------------------------------------------------------------
+static vector<Workload> makeWorkloads(bool quick, size_t totalBytes,
+   unsigned seed)
+{
+   mt19937 random(seed);
+   vector<Workload> workloads;
+   vector<int> dfaSizes = quick ? vector<int>{16, 1024} :
+      vector<int>{16, 1024, 65536};
+   vector<int> pathologicalSizes = quick ? vector<int>{8, 32} :
+      vector<int>{8, 32, 128};
+   vector<int> ruleCounts = quick ? vector<int>{10, 100} :
+      vector<int>{10, 100, 1000};
+
+   for(int nodeCount : dfaSizes)
+   {
+      Workload workload{"random_dfa", nodeCount, randomDfa(nodeCount, random),
+         true, {}, 0};
+      uniform_int_distribution<int> anyChar('a', 'd');
+      fillInputs(workload, totalBytes, [&]()
+      {
+         string input(64, 'a');
+         for(char& symbol : input)
+         {
+            symbol = static_cast<char>(anyChar(random));
+         }
+         return input;
+      });
+      workloads.push_back(move(workload));
+   }
+
+   for(int n : pathologicalSizes)
+   {
+      Workload workload{"pathological", n, pathologicalNfa(n), false, {}, 0};
+      uniform_int_distribution<int> anyLength(0, 3 * n);
+      fillInputs(workload, totalBytes, [&]()
+         {return string(anyLength(random), 'a');});
+      workloads.push_back(move(workload));
+   }
+
+   for(int ruleCount : ruleCounts)
+   {
+      vector<string> words;
+      Workload workload{"rule_union", ruleCount,
+         ruleUnion(ruleCount, random, words), false, {}, 0};
+      uniform_int_distribution<int> anyChar('a', 'p');
+      uniform_int_distribution<size_t> anyWord(0, words.size() - 1);
+      fillInputs(workload, totalBytes, [&]()
+      {
+         if(random() & 1)
+         {
+            return words[anyWord(random)];
+         }
+         string input(RULE_LENGTH, 'a');
+         for(char& symbol : input)
+         {
+            symbol = static_cast<char>(anyChar(random));
+         }
+         return input;
+      });
+      workloads.push_back(move(workload));
+   }
+   return workloads;
+}
+
+//------------------------------------------------------------------------------
+// resetPeakMemory()
+// Hands memory freed by earlier engines back to the system, where the C
+// library allows it, and makes the kernel restart the peak resident memory
+// (VmHWM) count at the current resident memory.  Supported by Linux 4.0 and
+// later; elsewhere the peak stays the process lifetime peak.
+//------------------------------------------------------------------------------
+static void resetPeakMemory(void)
+{
+#ifdef __GLIBC__
+   malloc_trim(0);
+#endif
+   ofstream clearRefs("/proc/self/clear_refs");
+   if(clearRefs)
+   {
+      clearRefs << "5";
+   }
+}
+
+//------------------------------------------------------------------------------
+// memoryKb(const char* field)
+// Returns field ("VmHWM:" for the peak, "VmRSS:" for the current resident
+// memory) from /proc/self/status, or the process lifetime peak from
+// getrusage() where there is no /proc.
+//------------------------------------------------------------------------------
+static long memoryKb(const char* field)
+{
+   ifstream status("/proc/self/status");
+   string line;
+   size_t fieldLength = strlen(field);
+   while(getline(status, line))
+   {
+      if(line.compare(0, fieldLength, field) == 0)
+      {
+         return strtol(line.c_str() + fieldLength, nullptr, 10);
+      }
+   }
+   struct rusage usage;
+   getrusage(RUSAGE_SELF, &usage);
+   return usage.ru_maxrss;
+}
+
+//------------------------------------------------------------------------------
+// millisecondsSince(chrono::steady_clock::time_point begin)
+// Returns the time elapsed since begin in milliseconds.
+//------------------------------------------------------------------------------
+static double millisecondsSince(chrono::steady_clock::time_point begin)
+{
+   return chrono::duration<double, milli>(chrono::steady_clock::now() -
+      begin).count();
+}
+
+//------------------------------------------------------------------------------
+// runEngine(const Workload& workload, const char* engine, bool& first,
+// Compile compile)
+// Resets the peak memory count, times compile(), which returns the engine,
+// then times checkString() over every input of workload once and prints
+// one JSON object.  first tells whether a separating comma is needed.
+//------------------------------------------------------------------------------
+template<class Compile>
+static void runEngine(const Workload& workload, const char* engine,
+   bool& first, Compile compile)
+{
+   resetPeakMemory();
+   long baseKb = memoryKb("VmRSS:");
+   auto compileBegin = chrono::steady_clock::now();
+   auto matcher = compile();
+   double compileMs = millisecondsSince(compileBegin);
+
+   size_t accepted = 0;
+   auto matchBegin = chrono::steady_clock::now();
+   for(const string& input : workload.inputs)
+   {
+      accepted += matcher.checkString(input) ? 1 : 0;
+   }
+   double matchMs = millisecondsSince(matchBegin);
+   long peakKb = memoryKb("VmHWM:");
+
+   printf("%s\n    {\"machine\": \"%s\", \"parameter\": %d, "
+      "\"nodes\": %zu, \"transitions\": %zu, \"engine\": \"%s\", "
+      "\"compile_ms\": %.3f, \"inputs\": %zu, \"input_bytes\": %zu, "
+      "\"ns_per_byte\": %.3f, \"matches_per_sec\": %.0f, "
+      "\"accepted\": %zu, \"peak_rss_kb\": %ld, \"added_rss_kb\": %ld}",
+      first ? "" : ",", workload.machine.c_str(), workload.parameter,
+      workload.fsm.nodes.size(), workload.fsm.transitions.size(), engine,
+      compileMs, workload.inputs.size(), workload.inputBytes,
+      matchMs * 1e6 / static_cast<double>(workload.inputBytes),
+      static_cast<double>(workload.inputs.size()) * 1e3 / matchMs,
+      accepted, peakKb, peakKb - baseKb);
+   fflush(stdout);
+   first = false;
+}
+
+//------------------------------------------------------------------------------
+// Parses the options, generates the workloads and runs every engine that
+// applies to each, printing {"benchmarks": [...]}.
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+   bool quick = false;
+   size_t totalBytes = 0;
+   unsigned seed = 1;
+   for(int arg = 1; arg < argc; ++arg)
+   {
+      if(strcmp(argv[arg], "--quick") == 0)
+      {
+         quick = true;
+      }
+      else if(strncmp(argv[arg], "--bytes=", 8) == 0)
+      {
+         totalBytes = strtoull(argv[arg] + 8, nullptr, 10);
+      }
+      else if(strncmp(argv[arg], "--seed=", 7) == 0)
+      {
+         seed = static_cast<unsigned>(strtoul(argv[arg] + 7, nullptr, 10));
+      }
+      else
+      {
+         fprintf(stderr, "usage: %s [--quick] [--bytes=N] [--seed=N]\n",
+            argv[0]);
+         return 1;
+      }
+   }
+   if(totalBytes == 0)
+   {
+      totalBytes = quick ? (size_t(1) << 20) : (size_t(16) << 20);
+   }
+
+   vector<Workload> workloads = makeWorkloads(quick, totalBytes, seed);
+   bool first = true;
+   printf("{\"benchmarks\": [");
+   for(const Workload& workload : workloads)
+   {
+      const FiniteStateMachine& fsm = workload.fsm;
+      if(static_cast<int>(fsm.nodes.size()) <= MAX_NFA_NODES)
+      {
+         runEngine(workload, "nfa_epsilon", first,
+            [&]() {return CompiledNfaEpsilon(fsm);});
+      }
+      if(workload.isDfa)
+      {
+         runEngine(workload, "dfa", first,
+            [&]() {return CompiledDfa(fsm);});
+         runEngine(workload, "jit", first,
+            [&]() {return JitDfa(fsm);});
+      }
+      CompiledNfaEpsilon translator(fsm, CompiledNfaEpsilon::NODE_SET);
+      runEngine(workload, "translate_argument", first,
+         [&]() {return CompiledDfa(translator.translateToDFA(fsm));});
+      runEngine(workload, "translate_member", first,
+         [&]() {return CompiledDfa(translator.translateToDFA());});
+   }
+   printf("\n]}\n");
+   return 0;
+}
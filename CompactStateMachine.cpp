@@ -0,0 +1,156 @@
+//------------------------------------------------------------------------------
+// CompactStateMachine.cpp
+// agent
+// 17 October 2026
+// Implementation for CompactStateMachine.h
+// Contains implementation for:
+//    Constructor x2
+//    operator=()
+//    reserve()
+//    toFiniteStateMachine()
+//------------------------------------------------------------------------------
+#include "CompactStateMachine.h"
+#include <unordered_map>
+
+//------------------------------------------------------------------------------
+// Converts fsm.  Node ids are assigned in order of first appearance: the
+// start node, then fsm.nodes, then any node only named by a transition.
+// Transitions keep their order; epsilon transitions go to the epsilon
+// arrays.
+//------------------------------------------------------------------------------
+CompactStateMachine::CompactStateMachine(const FiniteStateMachine& fsm)
+: start(0), nodes(0)
+{
+   unordered_map<int, int> denseIndex;
+   denseIndex.reserve(fsm.nodes.size() + 1);
+   auto indexOf = [&](int node)
+   {
+      auto found = denseIndex.emplace(node, nodes);
+      if(found.second)
+      {
+         addNode();
+      }
+      return found.first->second;
+   };
+
+   size_t epsilonTotal = 0;
+   for(const Transition& transition : fsm.transitions)
+   {
+      epsilonTotal += transition.isEpsilon ? 1 : 0;
+   }
+   reserve(static_cast<int>(fsm.nodes.size()) + 1,
+      fsm.transitions.size() - epsilonTotal, epsilonTotal);
+   start = indexOf(fsm.startNode);
+   for(int node : fsm.nodes)
+   {
+      indexOf(node);
+   }
+   for(const Transition& transition : fsm.transitions)
+   {
+      int source = indexOf(transition.source);
+      if(transition.isEpsilon)
+      {
+         addTransition(source, EPSILON, indexOf(transition.destination));
+      }
+      else
+      {
+         addTransition(source, transition.transitionChar,
+            indexOf(transition.destination));
+      }
+   }
+   for(int node : fsm.goalNodes)
+   {
+      auto found = denseIndex.find(node);
+      if(found != denseIndex.end())
+      {
+         setGoal(found->second);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// Move constructor.  The arrays change owner without being copied; other
+// is reset to the empty machine.
+//------------------------------------------------------------------------------
+CompactStateMachine::CompactStateMachine(CompactStateMachine&& other) noexcept
+: start(other.start), nodes(other.nodes), goalBits(move(other.goalBits)),
+  transitionSources(move(other.transitionSources)),
+  transitionSymbols(move(other.transitionSymbols)),
+  transitionDestinations(move(other.transitionDestinations)),
+  epsilonTransitionSources(move(other.epsilonTransitionSources)),
+  epsilonTransitionDestinations(move(other.epsilonTransitionDestinations))
+{
+   other.start = 0;
+   other.nodes = 0;
+}
+
+//------------------------------------------------------------------------------
+// operator=(CompactStateMachine&& other)
+// Move assignment.  The old arrays of this machine are freed, those of
+// other change owner, and other is reset to the empty machine.
+//------------------------------------------------------------------------------
+CompactStateMachine& CompactStateMachine::operator=(
+   CompactStateMachine&& other) noexcept
+{
+   if(this != &other)
+   {
+      start = other.start;
+      nodes = other.nodes;
+      goalBits = move(other.goalBits);
+      transitionSources = move(other.transitionSources);
+      transitionSymbols = move(other.transitionSymbols);
+      transitionDestinations = move(other.transitionDestinations);
+      epsilonTransitionSources = move(other.epsilonTransitionSources);
+      epsilonTransitionDestinations =
+         move(other.epsilonTransitionDestinations);
+      other.start = 0;
+      other.nodes = 0;
+   }
+   return *this;
+}
+
+//------------------------------------------------------------------------------
+// reserve(int nodeTotal, size_t transitionTotal, size_t epsilonTotal)
+// Sizes every array once so that building the machine does not reallocate.
+//------------------------------------------------------------------------------
+void CompactStateMachine::reserve(int nodeTotal, size_t transitionTotal,
+   size_t epsilonTotal)
+{
+   goalBits.reserve((nodeTotal + 63) / 64);
+   transitionSources.reserve(transitionTotal);
+   transitionSymbols.reserve(transitionTotal);
+   transitionDestinations.reserve(transitionTotal);
+   epsilonTransitionSources.reserve(epsilonTotal);
+   epsilonTransitionDestinations.reserve(epsilonTotal);
+}
+
+//------------------------------------------------------------------------------
+// toFiniteStateMachine()
+// Copies the machine into a FiniteStateMachine with the same node ids,
+// transitions first, then epsilon transitions.
+//------------------------------------------------------------------------------
+FiniteStateMachine CompactStateMachine::toFiniteStateMachine(void) const
+{
+   FiniteStateMachine fsm;
+   fsm.startNode = start;
+   fsm.nodes.reserve(nodes);
+   for(int node = 0; node < nodes; ++node)
+   {
+      fsm.nodes.emplace(node);
+      if(isGoal(node))
+      {
+         fsm.goalNodes.emplace(node);
+      }
+   }
+   for(size_t transition = 0; transition < transitionCount(); ++transition)
+   {
+      fsm.transitions.emplace_back(transitionSources[transition],
+         transitionSymbols[transition], transitionDestinations[transition]);
+   }
+   for(size_t epsilon = 0; epsilon < epsilonCount(); ++epsilon)
+   {
+      fsm.transitions.emplace_back(epsilonTransitionSources[epsilon], EPSILON,
+         epsilonTransitionDestinations[epsilon]);
+   }
+   return fsm;
+}
@@ -0,0 +1,163 @@
+//------------------------------------------------------------------------------
+// CompactStateMachine.h
+// agent
+// 17 October 2026
+// Contiguous builder representation of a finite state machine in DFA or
+// NFA-EPSILON format.
+//------------------------------------------------------------------------------
+#ifndef COMPACTSTATEMACHINE_H
+#define COMPACTSTATEMACHINE_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FiniteStateMachine.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// CompactStateMachine Class
+// Holds the same information as a FiniteStateMachine in a handful of flat
+// arrays instead of a list node per transition and a hash node per node:
+//    nodes       - always the dense ids 0 .. nodeCount() - 1
+//    goal nodes  - one bit per node in goalBits
+//    transitions - struct of arrays, transition t is sources[t],
+//                  symbols[t], destinations[t], in the order they were added
+//    epsilons    - epsilon transition e is epsilonSources[e],
+//                  epsilonDestinations[e], kept apart from the transitions
+//                  so that every char is an ordinary symbol
+// Building one with reserve() allocates a fixed number of blocks however
+// many nodes and transitions it holds, and it moves without copying: the
+// move operations take the arrays over and leave an empty machine behind.
+// Every class built from a
+// FiniteStateMachine can be built from a CompactStateMachine instead, taken
+// by const reference, and the translators produce them directly.
+// CompiledDfa, CompiledNfaEpsilon, its translators and TransitionIndex also
+// take one by rvalue reference, releasing its arrays as soon as they have
+// been read so that they are never held alongside the tables built from
+// them.
+// A FiniteStateMachine converts to a CompactStateMachine by renumbering its
+// nodes densely, start node first, and back with toFiniteStateMachine().
+// Public methods:
+//    reserve()
+//    addNode()
+//    setStartNode()
+//    setGoal()
+//    addTransition() x2
+//    nodeCount()
+//    transitionCount()
+//    epsilonCount()
+//    startNode()
+//    isGoal()
+//    sources()
+//    symbols()
+//    destinations()
+//    epsilonSources()
+//    epsilonDestinations()
+//    toFiniteStateMachine()
+// Members:
+//    start
+//    nodes
+//    goalBits
+//    transitionSources
+//    transitionSymbols
+//    transitionDestinations
+//    epsilonTransitionSources
+//    epsilonTransitionDestinations
+//------------------------------------------------------------------------------
+class CompactStateMachine
+{
+   public:
+      //Empty machine, start node 0 once a node is added
+      CompactStateMachine() : start(0), nodes(0) {}
+
+      //Converts fsm, renumbering its nodes densely with the start node first
+      explicit CompactStateMachine(const FiniteStateMachine& fsm);
+
+      //Copy constructor and assignment
+      CompactStateMachine(const CompactStateMachine& other) = default;
+      CompactStateMachine& operator=(const CompactStateMachine& other)
+         = default;
+
+      //Move constructor - takes the arrays over, other is left empty
+      CompactStateMachine(CompactStateMachine&& other) noexcept;
+
+      //Move assignment - takes the arrays over, other is left empty
+      CompactStateMachine& operator=(CompactStateMachine&& other) noexcept;
+
+      //Destructor - key word 'new' is not used.
+      ~CompactStateMachine(){}
+
+      //Reserves room for nodeTotal nodes, transitionTotal transitions and
+      //epsilonTotal epsilon transitions
+      void reserve(int nodeTotal, size_t transitionTotal,
+         size_t epsilonTotal = 0);
+
+      //Adds a node and returns its id, which is the previous nodeCount()
+      inline int addNode(void)
+         {if((nodes & 63) == 0) {goalBits.push_back(0);} return nodes++;}
+
+      //Makes node the start node
+      inline void setStartNode(int node) {start = node;}
+
+      //Makes node a goal node
+      inline void setGoal(int node)
+         {goalBits[node >> 6] |= uint64_t(1) << (node & 63);}
+
+      //Adds a transition between two nodes that have already been added
+      inline void addTransition(int source, char symbol, int destination)
+         {transitionSources.push_back(source);
+          transitionSymbols.push_back(symbol);
+          transitionDestinations.push_back(destination);}
+
+      //Adds an epsilon transition between two nodes that have been added
+      inline void addTransition(int source, EpsilonSymbol, int destination)
+         {epsilonTransitionSources.push_back(source);
+          epsilonTransitionDestinations.push_back(destination);}
+
+      //Number of nodes
+      inline int nodeCount(void) const {return nodes;}
+
+      //Number of transitions, epsilon transitions not included
+      inline size_t transitionCount(void) const
+         {return transitionSources.size();}
+
+      //Number of epsilon transitions
+      inline size_t epsilonCount(void) const
+         {return epsilonTransitionSources.size();}
+
+      //Start node
+      inline int startNode(void) const {return start;}
+
+      //Returns true if node is a goal node
+      inline bool isGoal(int node) const
+         {return (goalBits[node >> 6] >> (node & 63)) & 1;}
+
+      //Transition arrays, indexed by transition
+      inline const vector<int>& sources(void) const
+         {return transitionSources;}
+      inline const vector<char>& symbols(void) const
+         {return transitionSymbols;}
+      inline const vector<int>& destinations(void) const
+         {return transitionDestinations;}
+
+      //Epsilon transition arrays, indexed by epsilon transition
+      inline const vector<int>& epsilonSources(void) const
+         {return epsilonTransitionSources;}
+      inline const vector<int>& epsilonDestinations(void) const
+         {return epsilonTransitionDestinations;}
+
+      //Returns the same machine as a FiniteStateMachine
+      FiniteStateMachine toFiniteStateMachine(void) const;
+
+   private:
+      int start;                             //Start node
+      int nodes;                             //Number of nodes
+      vector<uint64_t> goalBits;             //One bit per node
+      vector<int> transitionSources;         //Source of each transition
+      vector<char> transitionSymbols;        //Symbol of each transition
+      vector<int> transitionDestinations;    //Destination of each transition
+      vector<int> epsilonTransitionSources;  //Source of each epsilon
+      vector<int> epsilonTransitionDestinations; //Destination of each epsilon
+};
+
+#endif // COMPACTSTATEMACHINE_H
@@ -5,71 +5,873 @@
 // Implementation for CompiledDfa.h
 // Matches input strings based on a FiniteStateMachine in DFA format
 // Contains implementation for:
-//    Constructor
+//    Constructor x3
+//    build()
+//    mergeDecidedStates()
+//    compressAlphabet()
+//    save()
+//    load()
+//    fileLayout()
+//    checksum()
 //    isMatch()
+//    advance()
+//    checkStringParallel()
+//    speculate()
+//    checkStrings()
+//    interleave()
+//    advanceScalar()
+//    advanceAvx2()
+//    advanceAvx512()
 //------------------------------------------------------------------------------
 #include "CompiledDfa.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define COMPILEDDFA_X86_GATHER 1
+#include <immintrin.h>
+#else
+#define COMPILEDDFA_X86_GATHER 0
+#endif
+
+//------------------------------------------------------------------------------
+// Constructs a CompiledDfa based on a CompactStateMachine formatted for DFA.
+// If minimize is set, finStMch is replaced by its minimal equivalent first.
+// Calls:
+//    build()
+//    mergeDecidedStates()
+//------------------------------------------------------------------------------
+CompiledDfa::CompiledDfa(const CompactStateMachine& finStMch, bool minimize)
+: start(DEAD_STATE), acceptState(DEAD_STATE), stateCount(1), classCount(0),
+  byteClass(nullptr),
+  transitionTable(nullptr), goalBitmap(nullptr)
+{
+   if(minimize)
+   {
+      build(DfaMinimizer(finStMch).minimizeCompact());
+   }
+   else
+   {
+      build(finStMch);
+   }
+}
 
 //------------------------------------------------------------------------------
-// Constructs a CompiledDfa based on a FiniteStateMachine formatted for DFA.
-// Key/value pairs must be made for the stateTransitionMap otherwise every
-// member is initialized in the initialization list.
+// Constructs a CompiledDfa from a CompactStateMachine it takes over.  With
+// minimize set, finStMch is released once the minimizer has indexed it,
+// before the minimal DFA is built.
+// Calls:
+//    build()
 //------------------------------------------------------------------------------
-CompiledDfa::CompiledDfa(FiniteStateMachine finStMch)
-: start(finStMch.startNode), key(""), goalNodes(finStMch.goalNodes)
+CompiledDfa::CompiledDfa(CompactStateMachine&& finStMch, bool minimize)
+: start(DEAD_STATE), acceptState(DEAD_STATE), stateCount(1), classCount(0),
+  byteClass(nullptr),
+  transitionTable(nullptr), goalBitmap(nullptr)
 {
-   for(Transition transition : finStMch.transitions)
+   CompactStateMachine machine(move(finStMch));
+   if(minimize)
    {
-      key = to_string(transition.source) + transition.transitionChar;
-      stateTransitionMap.emplace(key, transition.destination);
+      DfaMinimizer minimizer(machine);
+      machine = CompactStateMachine();
+      machine = minimizer.minimizeCompact();
    }
+   build(machine);
 }
 
 //------------------------------------------------------------------------------
-// Recursive function for comparing an inputString against the DFA.
-// Base cases:
-//    1. key is not in stateTransitionMap
-//    2. posInString is at the end of inputString - check whether curState
-//    is a goal node.
+// build(const CompactStateMachine& finStMch)
+// Node n of finStMch becomes state n + 1, after DEAD_STATE, then a full
+// ALPHABET_SIZE wide table and the goal flags are filled in.  As with the
+// old key map, the first transition seen for a given source node and
+// character wins.  An empty finStMch, as left by the default constructor
+// or a move, has no start node and starts in DEAD_STATE.  Decided states are
+// then merged and the rest renumbered densely, and the full table is
+// narrowed to one column per byte class.
+// Calls:
+//    mergeDecidedStates()
+//    compressAlphabet()
 //------------------------------------------------------------------------------
-bool CompiledDfa::isMatch(string inputString, unsigned posInString, int curState)
+void CompiledDfa::build(const CompactStateMachine& finStMch)
 {
-   key = to_string(curState) + inputString[posInString];
+   stateCount = finStMch.nodeCount() + 1;
+   start = finStMch.nodeCount() > 0 ? finStMch.startNode() + 1 : DEAD_STATE;
 
-   auto getNextState = stateTransitionMap.find(key);
-   if(getNextState == stateTransitionMap.end())
+   const vector<int>& sources = finStMch.sources();
+   const vector<char>& symbols = finStMch.symbols();
+   const vector<int>& destinations = finStMch.destinations();
+   vector<int> byteTable(stateCount * ALPHABET_SIZE, DEAD_STATE);
+   vector<bool> filled(stateCount * ALPHABET_SIZE, false);
+   for(size_t transition = 0; transition < sources.size(); ++transition)
    {
-      return false;
+      int cell = (sources[transition] + 1) * ALPHABET_SIZE +
+         static_cast<unsigned char>(symbols[transition]);
+      if(!filled[cell])
+      {
+         byteTable[cell] = destinations[transition] + 1;
+         filled[cell] = true;
+      }
    }
+   vector<char> goals(stateCount, 0);
+   for(int node = 0; node < finStMch.nodeCount(); ++node)
+   {
+      goals[node + 1] = finStMch.isGoal(node) ? 1 : 0;
+   }
+   mergeDecidedStates(byteTable, goals);
+
+   shared_ptr<TableStorage> tables = make_shared<TableStorage>();
+   compressAlphabet(byteTable, *tables);
 
-   if(posInString == inputString.length() - 1)
+   tables->goalBitmap.assign((stateCount + 63) / 64, 0);
+   for(int state = 0; state < stateCount; ++state)
    {
-      auto node = goalNodes.find(getNextState->second);
-      return (node == goalNodes.end()) ? false : true;
+      if(goals[state])
+      {
+         tables->goalBitmap[state >> 6] |= uint64_t(1) << (state & 63);
+      }
    }
-   else
+
+   byteClass = tables->byteClass.data();
+   transitionTable = tables->transitionTable.data();
+   goalBitmap = tables->goalBitmap.data();
+   storage = tables;
+}
+
+//------------------------------------------------------------------------------
+// mergeDecidedStates(vector<int>& byteTable, vector<char>& goals)
+// A state is dead if no goal can be reached from it: a breadth first search
+// backwards from the goal states over the reversed transitions finds the
+// others.  A goal state is an accepting sink if every byte leads it to
+// another accepting sink: starting from all goal states, any one with a
+// transition to a state outside the set is dropped, and so are, in turn,
+// its predecessors still in the set, until nothing changes.
+// Every dead state is merged into DEAD_STATE and every accepting sink into
+// one state, ACCEPT_STATE, that loops to itself on every byte.  The other
+// states follow in their old order, so both decided states have the lowest
+// numbers and advance() tells them apart from the rest with one compare.
+// byteTable, goals, stateCount, start and acceptState are updated.
+//------------------------------------------------------------------------------
+void CompiledDfa::mergeDecidedStates(vector<int>& byteTable,
+   vector<char>& goals)
+{
+   vector<int> reverseOffsets(stateCount + 1, 0);
+   for(int cell = ALPHABET_SIZE; cell < stateCount * ALPHABET_SIZE; ++cell)
+   {
+      ++reverseOffsets[byteTable[cell] + 1];
+   }
+   for(int state = 0; state < stateCount; ++state)
+   {
+      reverseOffsets[state + 1] += reverseOffsets[state];
+   }
+   vector<int> predecessors(reverseOffsets[stateCount]);
+   vector<int> fill(reverseOffsets.begin(), reverseOffsets.end() - 1);
+   for(int cell = ALPHABET_SIZE; cell < stateCount * ALPHABET_SIZE; ++cell)
+   {
+      predecessors[fill[byteTable[cell]]++] = cell / ALPHABET_SIZE;
+   }
+
+   vector<char> live(goals);
+   vector<char> sink(goals);
+   vector<int> pending;
+   for(int state = 1; state < stateCount; ++state)
+   {
+      if(live[state])
+      {
+         pending.push_back(state);
+      }
+   }
+   while(!pending.empty())
+   {
+      int state = pending.back();
+      pending.pop_back();
+      for(int pred = reverseOffsets[state];
+         pred < reverseOffsets[state + 1]; ++pred)
+      {
+         if(!live[predecessors[pred]])
+         {
+            live[predecessors[pred]] = 1;
+            pending.push_back(predecessors[pred]);
+         }
+      }
+   }
+
+   for(int state = 0; state < stateCount; ++state)
+   {
+      if(!sink[state])
+      {
+         pending.push_back(state);
+      }
+   }
+   while(!pending.empty())
+   {
+      int state = pending.back();
+      pending.pop_back();
+      for(int pred = reverseOffsets[state];
+         pred < reverseOffsets[state + 1]; ++pred)
+      {
+         if(sink[predecessors[pred]])
+         {
+            sink[predecessors[pred]] = 0;
+            pending.push_back(predecessors[pred]);
+         }
+      }
+   }
+
+   bool hasSink = find(sink.begin(), sink.end(), 1) != sink.end();
+   acceptState = hasSink ? ACCEPT_STATE : DEAD_STATE;
+   vector<int> renumber(stateCount, DEAD_STATE);
+   int merged = acceptState + 1;
+   for(int state = 1; state < stateCount; ++state)
+   {
+      if(sink[state])
+      {
+         renumber[state] = ACCEPT_STATE;
+      }
+      else if(live[state])
+      {
+         renumber[state] = merged++;
+      }
+   }
+
+   vector<int> mergedTable(merged * ALPHABET_SIZE, DEAD_STATE);
+   vector<char> mergedGoals(merged, 0);
+   for(int state = 1; state < stateCount; ++state)
    {
-      return isMatch(inputString, posInString + 1, getNextState->second);
+      int row = renumber[state];
+      if(row == DEAD_STATE)
+      {
+         continue;
+      }
+      mergedGoals[row] = goals[state];
+      for(int byte = 0; byte < ALPHABET_SIZE; ++byte)
+      {
+         mergedTable[row * ALPHABET_SIZE + byte] =
+            renumber[byteTable[state * ALPHABET_SIZE + byte]];
+      }
    }
+   stateCount = merged;
+   start = renumber[start];
+   byteTable.swap(mergedTable);
+   goals.swap(mergedGoals);
 }
 
+//------------------------------------------------------------------------------
+// Empty CompiledDfa for load() to point at a file mapping.
+//------------------------------------------------------------------------------
+CompiledDfa::CompiledDfa()
+: start(DEAD_STATE), acceptState(DEAD_STATE), stateCount(0), classCount(0),
+  byteClass(nullptr),
+  transitionTable(nullptr), goalBitmap(nullptr)
+{
+}
 
+//------------------------------------------------------------------------------
+// compressAlphabet(const vector<int>& byteTable, TableStorage& tables)
+// Two bytes are equivalent when every state moves to the same next state on
+// both, i.e. when their columns of byteTable are equal.  Each distinct
+// column becomes one class, numbered in order of its lowest byte, and the
+// transition table in tables keeps one column per class.  Rules that only
+// name a few characters leave a handful of classes, so the table shrinks
+// to a small fraction of ALPHABET_SIZE columns per state.
+//------------------------------------------------------------------------------
+void CompiledDfa::compressAlphabet(const vector<int>& byteTable,
+   TableStorage& tables)
+{
+   map<vector<int>, int> classOfColumn;
+   vector<int> representative;
+   vector<int> column(stateCount);
+   tables.byteClass.assign(ALPHABET_SIZE, 0);
+   for(int byte = 0; byte < ALPHABET_SIZE; ++byte)
+   {
+      for(int state = 0; state < stateCount; ++state)
+      {
+         column[state] = byteTable[state * ALPHABET_SIZE + byte];
+      }
+      auto found = classOfColumn.emplace(column,
+         static_cast<int>(representative.size()));
+      if(found.second)
+      {
+         representative.push_back(byte);
+      }
+      tables.byteClass[byte] =
+         static_cast<unsigned char>(found.first->second);
+   }
 
+   classCount = static_cast<int>(representative.size());
+   tables.transitionTable.resize(stateCount * classCount);
+   for(int state = 0; state < stateCount; ++state)
+   {
+      for(int byteCls = 0; byteCls < classCount; ++byteCls)
+      {
+         tables.transitionTable[state * classCount + byteCls] =
+            byteTable[state * ALPHABET_SIZE + representative[byteCls]];
+      }
+   }
+}
 
+//------------------------------------------------------------------------------
+// save(const string& path)
+// Lays the file out in memory (header, then each table at its aligned
+// offset with zero padding between), hashes everything after the header
+// and writes the image in one go.
+// Calls:
+//    fileLayout()
+//    checksum()
+//------------------------------------------------------------------------------
+bool CompiledDfa::save(const string& path) const
+{
+   FileHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, "CDFA\r\n\x1a\n", sizeof(header.magic));
+   header.version = FILE_VERSION;
+   header.byteOrder = BYTE_ORDER_MARK;
+   header.start = start;
+   header.stateCount = stateCount;
+   header.classCount = classCount;
+   header.acceptState = acceptState;
+   fileLayout(header);
 
+   vector<unsigned char> image(header.fileSize, 0);
+   memcpy(&image[header.classOffset], byteClass, ALPHABET_SIZE);
+   memcpy(&image[header.tableOffset], transitionTable,
+      size_t(stateCount) * classCount * sizeof(int));
+   memcpy(&image[header.goalOffset], goalBitmap,
+      size_t(stateCount + 63) / 64 * sizeof(uint64_t));
+   header.checksum = checksum(&image[sizeof(header)],
+      image.size() - sizeof(header));
+   memcpy(&image[0], &header, sizeof(header));
 
+   ofstream file(path, ios::binary | ios::trunc);
+   file.write(reinterpret_cast<const char*>(image.data()), image.size());
+   file.close();
+   return !file.fail();
+}
 
+//------------------------------------------------------------------------------
+// load(const string& path, bool verify)
+// Maps the file read-only and checks the header: magic, version (older
+// versions are rejected, see FileHeader), byte order, counts, and that the
+// offsets and size are exactly the ones fileLayout() gives for those
+// counts, and that acceptState is either DEAD_STATE or ACCEPT_STATE.  With verify the checksum is compared, every
+// byte class and next state is range checked, so a damaged file is rejected
+// instead of read out of bounds, and the accepting sink, if any, is checked
+// to be a goal that loops to itself on every byte.  The tables are
+// used in place; the mapping is released with the last copy of the
+// CompiledDfa.
+// Calls:
+//    fileLayout()
+//    checksum()
+//------------------------------------------------------------------------------
+unique_ptr<CompiledDfa> CompiledDfa::load(const string& path, bool verify)
+{
+   int fd = open(path.c_str(), O_RDONLY);
+   if(fd < 0)
+   {
+      return nullptr;
+   }
+   struct stat fileStat;
+   if(fstat(fd, &fileStat) != 0 ||
+      size_t(fileStat.st_size) < sizeof(FileHeader))
+   {
+      close(fd);
+      return nullptr;
+   }
+   size_t fileSize = fileStat.st_size;
+   void* mapped = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if(mapped == MAP_FAILED)
+   {
+      return nullptr;
+   }
+   shared_ptr<const void> mapping(mapped, [fileSize](const void* address)
+      {munmap(const_cast<void*>(address), fileSize);});
+   const unsigned char* bytes = static_cast<const unsigned char*>(mapped);
 
+   FileHeader header;
+   memcpy(&header, bytes, sizeof(header));
+   if(memcmp(header.magic, "CDFA\r\n\x1a\n", sizeof(header.magic)) != 0 ||
+      header.version != FILE_VERSION || header.byteOrder != BYTE_ORDER_MARK ||
+      header.stateCount < 1 || header.classCount < 1 ||
+      header.classCount > ALPHABET_SIZE || header.start < 0 ||
+      header.start >= header.stateCount || header.fileSize != fileSize ||
+      (header.acceptState != DEAD_STATE &&
+         (header.acceptState != ACCEPT_STATE || header.stateCount < 2)))
+   {
+      return nullptr;
+   }
+   FileHeader expected = header;
+   fileLayout(expected);
+   if(expected.classOffset != header.classOffset ||
+      expected.tableOffset != header.tableOffset ||
+      expected.goalOffset != header.goalOffset ||
+      expected.fileSize != header.fileSize)
+   {
+      return nullptr;
+   }
 
+   unique_ptr<CompiledDfa> loaded(new CompiledDfa());
+   loaded->start = header.start;
+   loaded->acceptState = header.acceptState;
+   loaded->stateCount = header.stateCount;
+   loaded->classCount = header.classCount;
+   loaded->byteClass = bytes + header.classOffset;
+   loaded->transitionTable =
+      reinterpret_cast<const int*>(bytes + header.tableOffset);
+   loaded->goalBitmap =
+      reinterpret_cast<const uint64_t*>(bytes + header.goalOffset);
+   loaded->storage = mapping;
 
+   if(verify)
+   {
+      if(checksum(bytes + sizeof(header), fileSize - sizeof(header)) !=
+         header.checksum)
+      {
+         return nullptr;
+      }
+      for(int byte = 0; byte < ALPHABET_SIZE; ++byte)
+      {
+         if(loaded->byteClass[byte] >= header.classCount)
+         {
+            return nullptr;
+         }
+      }
+      size_t cells = size_t(header.stateCount) * header.classCount;
+      for(size_t cell = 0; cell < cells; ++cell)
+      {
+         if(loaded->transitionTable[cell] < 0 ||
+            loaded->transitionTable[cell] >= header.stateCount)
+         {
+            return nullptr;
+         }
+      }
+      if(loaded->acceptState == ACCEPT_STATE)
+      {
+         const int* row = loaded->transitionTable +
+            ACCEPT_STATE * header.classCount;
+         if(!loaded->isGoalState(ACCEPT_STATE) || count(row,
+            row + header.classCount, ACCEPT_STATE) != header.classCount)
+         {
+            return nullptr;
+         }
+      }
+   }
+   return loaded;
+}
 
+//------------------------------------------------------------------------------
+// fileLayout(FileHeader& header)
+// The header comes first, then byteClass, transitionTable and goalBitmap,
+// each starting at the next multiple of FILE_ALIGNMENT.  Offsets are from
+// the start of the file, so the file holds no addresses and can be mapped
+// anywhere.
+//------------------------------------------------------------------------------
+void CompiledDfa::fileLayout(FileHeader& header)
+{
+   auto align = [](uint64_t offset)
+      {return (offset + FILE_ALIGNMENT - 1) / FILE_ALIGNMENT * FILE_ALIGNMENT;};
+   header.classOffset = align(sizeof(FileHeader));
+   header.tableOffset = align(header.classOffset + ALPHABET_SIZE);
+   header.goalOffset = align(header.tableOffset +
+      uint64_t(header.stateCount) * header.classCount * sizeof(int32_t));
+   header.fileSize = header.goalOffset +
+      (uint64_t(header.stateCount) + 63) / 64 * sizeof(uint64_t);
+}
 
+//------------------------------------------------------------------------------
+// checksum(const unsigned char* bytes, size_t length)
+// 64 bit FNV-1a.
+//------------------------------------------------------------------------------
+uint64_t CompiledDfa::checksum(const unsigned char* bytes, size_t length)
+{
+   uint64_t hash = 14695981039346656037ULL;
+   for(size_t pos = 0; pos < length; ++pos)
+   {
+      hash ^= bytes[pos];
+      hash *= 1099511628211ULL;
+   }
+   return hash;
+}
+
+//------------------------------------------------------------------------------
+// Walks input through the transition table, one indexed load per byte.
+// Stops early once DEAD_STATE or ACCEPT_STATE is reached since no
+// transition leaves either.
+// An empty input matches if the start node is a goal node.
+// Nothing is copied or allocated; input is only read.
+// Calls:
+//    advance()
+//------------------------------------------------------------------------------
+bool CompiledDfa::isMatch(const char* input, size_t length) const
+{
+   bool accepted = isGoalState(advance(start, input, length));
+   stats.recordMatches(1, accepted ? 1 : 0);
+   return accepted;
+}
+
+//------------------------------------------------------------------------------
+// advance(int state, const char* input, size_t length)
+// Walks the table from state over input and returns the state reached.
+// Stops early at a decided state, which no input leaves.  The decided
+// states are the lowest numbered, so one compare against acceptState
+// checks for both.
+//------------------------------------------------------------------------------
+int CompiledDfa::advance(int state, const char* input, size_t length) const
+{
+   size_t pos = 0;
+   for(; pos < length && state > acceptState; ++pos)
+   {
+      state = nextState(state, static_cast<unsigned char>(input[pos]));
+   }
+   stats.recordWalk(length, pos, state == DEAD_STATE,
+      isAcceptState(state));
+   return state;
+}
+
+//------------------------------------------------------------------------------
+// checkStringParallel(const char* input, size_t length,
+// WorkStealingPool& pool)
+// Splits input into one chunk per pool thread, as long as every chunk is at
+// least MIN_PARALLEL_CHUNK and PARALLEL_CHUNK_PER_STATE bytes per state
+// long; shorter inputs are matched serially.  The first chunk is advanced
+// from start, every other one speculated from all states, all in parallel.
+// The final state is then found by composing the chunks' state transfers,
+// in order, starting from the first chunk's final state.
+// Calls:
+//    isMatch()
+//    advance()
+//    speculate()
+//------------------------------------------------------------------------------
+bool CompiledDfa::checkStringParallel(const char* input, size_t length,
+   WorkStealingPool& pool) const
+{
+   size_t minChunk = max(MIN_PARALLEL_CHUNK,
+      size_t(stateCount) * PARALLEL_CHUNK_PER_STATE);
+   size_t chunks = min<size_t>(pool.size(), length / minChunk);
+   if(chunks < 2)
+   {
+      return isMatch(input, length);
+   }
+
+   size_t chunkLength = length / chunks;
+   vector<StateTransfer> transfers(chunks);
+   int state = start;
+   pool.parallelFor(chunks, 1, [&](size_t begin, size_t end)
+   {
+      for(size_t chunk = begin; chunk < end; ++chunk)
+      {
+         const char* chunkInput = input + chunk * chunkLength;
+         size_t chunkSize = (chunk + 1 == chunks) ?
+            length - chunk * chunkLength : chunkLength;
+         if(chunk == 0)
+         {
+            state = advance(start, chunkInput, chunkSize);
+         }
+         else
+         {
+            speculate(chunkInput, chunkSize, transfers[chunk]);
+         }
+      }
+   });
+
+   for(size_t chunk = 1; chunk < chunks && state > acceptState; ++chunk)
+   {
+      const StateTransfer& transfer = transfers[chunk];
+      state = transfer.finalStates[transfer.laneOf[state]];
+   }
+   bool accepted = isGoalState(state);
+   stats.recordMatches(1, accepted ? 1 : 0);
+   return accepted;
+}
+
+//------------------------------------------------------------------------------
+// speculate(const char* input, size_t length, StateTransfer& transfer)
+// Starts one lane in every state and advances all lanes SPECULATE_BLOCK
+// bytes at a time.  After each block, lanes in the same state are merged
+// and laneOf is remapped to the surviving lanes; DEAD_STATE and any other
+// state the lanes funnel into absorb most of them quickly.  Once a single
+// lane is left the rest of the chunk is a plain advance().
+// Calls:
+//    advance()
+//------------------------------------------------------------------------------
+void CompiledDfa::speculate(const char* input, size_t length,
+   StateTransfer& transfer) const
+{
+   vector<int>& lanes = transfer.finalStates;
+   transfer.laneOf.resize(stateCount);
+   iota(transfer.laneOf.begin(), transfer.laneOf.end(), 0);
+   lanes = transfer.laneOf;
+
+   vector<int> laneOfState(stateCount, -1);
+   vector<int> merged;
+   vector<int> remap;
+   size_t pos = 0;
+   while(pos < length && lanes.size() > 1)
+   {
+      size_t blockEnd = min(length, pos + SPECULATE_BLOCK);
+      for(; pos < blockEnd; ++pos)
+      {
+         unsigned char inputChar = static_cast<unsigned char>(input[pos]);
+         for(int& laneState : lanes)
+         {
+            laneState = nextState(laneState, inputChar);
+         }
+      }
 
+      merged.clear();
+      remap.resize(lanes.size());
+      for(size_t lane = 0; lane < lanes.size(); ++lane)
+      {
+         int& survivor = laneOfState[lanes[lane]];
+         if(survivor < 0)
+         {
+            survivor = static_cast<int>(merged.size());
+            merged.push_back(lanes[lane]);
+         }
+         remap[lane] = survivor;
+      }
+      for(int laneState : merged)
+      {
+         laneOfState[laneState] = -1;
+      }
+      if(merged.size() < lanes.size())
+      {
+         for(int& lane : transfer.laneOf)
+         {
+            lane = remap[lane];
+         }
+         lanes.swap(merged);
+      }
+   }
+   if(pos < length)
+   {
+      lanes[0] = advance(lanes[0], input + pos, length - pos);
+   }
+}
 
+//------------------------------------------------------------------------------
+// checkStrings(const string_view* inputs, size_t count, bool* results,
+// InterleaveMode mode)
+// Picks the lane engine.  A requested gather engine the CPU (or compiler)
+// lacks falls back to 8 scalar lanes, which is also what INTERLEAVE_AUTO
+// uses.
+// Calls:
+//    interleave()
+//------------------------------------------------------------------------------
+void CompiledDfa::checkStrings(const string_view* inputs, size_t count,
+   bool* results, InterleaveMode mode) const
+{
+#if COMPILEDDFA_X86_GATHER
+   bool hasAvx512 = __builtin_cpu_supports("avx512f");
+   bool hasAvx2 = __builtin_cpu_supports("avx2");
+   if(mode == INTERLEAVE_AVX512 && hasAvx512)
+   {
+      interleave<16>(inputs, count, results, advanceAvx512);
+      return;
+   }
+   if(mode == INTERLEAVE_AVX2 && hasAvx2)
+   {
+      interleave<8>(inputs, count, results, advanceAvx2);
+      return;
+   }
+#else
+   (void)mode;
+#endif
+   interleave<8>(inputs, count, results, advanceScalar<8>);
+}
 
+//------------------------------------------------------------------------------
+// interleave(const string_view* inputs, size_t count, bool* results,
+// Advance advance)
+// Keeps WIDTH inputs in flight.  Each round advances every lane by the same
+// number of bytes - the shortest remaining input, at most INTERLEAVE_BLOCK -
+// then retires lanes that are finished or in a decided state and refills
+// them with the next inputs.  Idle lanes sit in DEAD_STATE on a block of zero
+// bytes, which never leaves DEAD_STATE, so advance never needs a lane mask.
+// Lanes only notice decided states at the end of a block, so statesVisited
+// counts whole blocks.
+//------------------------------------------------------------------------------
+template<int WIDTH, class Advance>
+void CompiledDfa::interleave(const string_view* inputs, size_t count,
+   bool* results, Advance advance) const
+{
+   static const unsigned char idleBytes[INTERLEAVE_BLOCK] = {0};
+   const unsigned char* lanes[WIDTH];
+   int states[WIDTH];
+   size_t remaining[WIDTH];
+   size_t owner[WIDTH];
+   size_t nextInput = 0;
+   int busyLanes = 0;
 
+   auto refill = [&](int lane)
+   {
+      while(nextInput < count)
+      {
+         size_t input = nextInput++;
+         if(inputs[input].empty())
+         {
+            results[input] = isGoalState(start);
+            stats.recordWalk(0, 0, false);
+            continue;
+         }
+         lanes[lane] =
+            reinterpret_cast<const unsigned char*>(inputs[input].data());
+         states[lane] = start;
+         remaining[lane] = inputs[input].size();
+         owner[lane] = input;
+         ++busyLanes;
+         return;
+      }
+      lanes[lane] = idleBytes;
+      states[lane] = DEAD_STATE;
+      remaining[lane] = 0;
+   };
 
+   for(int lane = 0; lane < WIDTH; ++lane)
+   {
+      refill(lane);
+   }
+   while(busyLanes > 0)
+   {
+      size_t block = INTERLEAVE_BLOCK;
+      for(int lane = 0; lane < WIDTH; ++lane)
+      {
+         if(remaining[lane] > 0)
+         {
+            block = min(block, remaining[lane]);
+         }
+      }
+      advance(transitionTable, byteClass, classCount, lanes, states, block);
+      for(int lane = 0; lane < WIDTH; ++lane)
+      {
+         if(remaining[lane] == 0)
+         {
+            continue;
+         }
+         lanes[lane] += block;
+         remaining[lane] -= block;
+         if(remaining[lane] == 0 || states[lane] <= acceptState)
+         {
+            results[owner[lane]] = isGoalState(states[lane]);
+            size_t length = inputs[owner[lane]].size();
+            stats.recordWalk(length, length - remaining[lane],
+               states[lane] == DEAD_STATE, isAcceptState(states[lane]));
+            --busyLanes;
+            refill(lane);
+         }
+      }
+   }
+   if(STATS_ENABLED)
+   {
+      stats.recordMatches(count, count_if(results, results + count,
+         [](bool result) {return result;}));
+   }
+}
 
+//------------------------------------------------------------------------------
+// advanceScalar(const int* table, const unsigned char* byteClass,
+// int classCount, const unsigned char* const* lanes, int* states,
+// size_t length)
+// One class lookup and one table load per lane per byte; the loads of
+// different lanes do not depend on each other, so they are in flight
+// together.
+//------------------------------------------------------------------------------
+template<int WIDTH>
+void CompiledDfa::advanceScalar(const int* table,
+   const unsigned char* byteClass, int classCount,
+   const unsigned char* const* lanes, int* states, size_t length)
+{
+   for(size_t pos = 0; pos < length; ++pos)
+   {
+      for(int lane = 0; lane < WIDTH; ++lane)
+      {
+         states[lane] = table[states[lane] * classCount +
+            byteClass[lanes[lane][pos]]];
+      }
+   }
+}
 
+#if COMPILEDDFA_X86_GATHER
+//------------------------------------------------------------------------------
+// advanceAvx2(const int* table, const unsigned char* byteClass,
+// int classCount, const unsigned char* const* lanes, int* states,
+// size_t length)
+// Keeps 8 lane states in one register and fetches all 8 next states with a
+// single gather per byte.  The byte classes are looked up with plain loads
+// while the lanes are gathered into a register.
+//------------------------------------------------------------------------------
+__attribute__((target("avx2")))
+void CompiledDfa::advanceAvx2(const int* table,
+   const unsigned char* byteClass, int classCount,
+   const unsigned char* const* lanes, int* states, size_t length)
+{
+   __m256i curStates =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(states));
+   __m256i rowWidth = _mm256_set1_epi32(classCount);
+   __m256i allLanes = _mm256_set1_epi32(-1);
+   for(size_t pos = 0; pos < length; ++pos)
+   {
+      __m256i inputClasses = _mm256_setr_epi32(byteClass[lanes[0][pos]],
+         byteClass[lanes[1][pos]], byteClass[lanes[2][pos]],
+         byteClass[lanes[3][pos]], byteClass[lanes[4][pos]],
+         byteClass[lanes[5][pos]], byteClass[lanes[6][pos]],
+         byteClass[lanes[7][pos]]);
+      __m256i cells = _mm256_add_epi32(_mm256_mullo_epi32(curStates, rowWidth),
+         inputClasses);
+      curStates = _mm256_mask_i32gather_epi32(curStates, table, cells,
+         allLanes, 4);
+   }
+   _mm256_storeu_si256(reinterpret_cast<__m256i*>(states), curStates);
+}
 
+//------------------------------------------------------------------------------
+// advanceAvx512(const int* table, const unsigned char* byteClass,
+// int classCount, const unsigned char* const* lanes, int* states,
+// size_t length)
+// AVX-512 version of advanceAvx2(), 16 lanes per gather.
+//------------------------------------------------------------------------------
+__attribute__((target("avx512f")))
+void CompiledDfa::advanceAvx512(const int* table,
+   const unsigned char* byteClass, int classCount,
+   const unsigned char* const* lanes, int* states, size_t length)
+{
+   __m512i curStates = _mm512_loadu_si512(states);
+   __m512i rowWidth = _mm512_set1_epi32(classCount);
+   alignas(64) int inputClasses[16];
+   for(size_t pos = 0; pos < length; ++pos)
+   {
+      for(int lane = 0; lane < 16; ++lane)
+      {
+         inputClasses[lane] = byteClass[lanes[lane][pos]];
+      }
+      __m512i cells = _mm512_add_epi32(_mm512_mullo_epi32(curStates, rowWidth),
+         _mm512_load_si512(inputClasses));
+      curStates = _mm512_mask_i32gather_epi32(curStates, 0xFFFF, cells,
+         table, 4);
+   }
+   _mm512_storeu_si512(states, curStates);
+}
+#else
+//------------------------------------------------------------------------------
+// Gather engines are only built for x86-64 with GCC or Clang; checkStrings()
+// never selects them elsewhere.
+//------------------------------------------------------------------------------
+void CompiledDfa::advanceAvx2(const int* table,
+   const unsigned char* byteClass, int classCount,
+   const unsigned char* const* lanes, int* states, size_t length)
+{
+   advanceScalar<8>(table, byteClass, classCount, lanes, states, length);
+}
 
+void CompiledDfa::advanceAvx512(const int* table,
+   const unsigned char* byteClass, int classCount,
+   const unsigned char* const* lanes, int* states, size_t length)
+{
+   advanceScalar<16>(table, byteClass, classCount, lanes, states, length);
+}
+#endif
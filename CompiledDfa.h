@@ -7,53 +7,350 @@
 #ifndef COMPILEDDFA_H
 #define COMPILEDDFA_H
 #include <iostream>
+#include <cstdint>
 #include <unordered_set>
 #include <unordered_map>
 #include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <string_view>
 #include "FiniteStateMachine.h"
+#include "CompactStateMachine.h"
+#include "DfaMinimizer.h"
+#include "EngineStats.h"
+#include "WorkStealingPool.h"
 
 using namespace std;
 //------------------------------------------------------------------------------
 // CompiledDFA Class
 // Matches input strings based on a FiniteStateMachine in DFA format
 // No defaul constructor, instead can only be constructed with a
-// FiniteStateMachine - should be formatted for DFA but there is no
-// validation that the FiniteStateMachine is in DFA format.
-// Only one public method:
-//    checkString()
-// Only one private method:
+// FiniteStateMachine or CompactStateMachine - should be formatted for DFA but
+// there is no validation that it is in DFA format.  A FiniteStateMachine is
+// converted to a CompactStateMachine first.
+// Nodes are renumbered densely at construction time and transitions are
+// stored in a flat stateCount x classCount table of next-state indices.
+// Row DEAD_STATE is a sink that stands in for every missing transition.
+// Bytes that every state treats alike share a byte class, and byteClass
+// maps each of the ALPHABET_SIZE byte values to its class, so the table is
+// only as wide as the number of distinctions the DFA actually makes.
+// When constructed with minimize set, the FiniteStateMachine is first reduced
+// to its minimal equivalent by DfaMinimizer.
+// States whose result no further input can change are found at construction:
+// dead states, from which no goal node can be reached, all become
+// DEAD_STATE, and accepting sinks, goal states from which every input leads
+// to another goal state, all become ACCEPT_STATE.  Matching stops at the
+// byte that reaches either one, so an input that is decided early is not
+// read to its end.  acceptState is DEAD_STATE if the DFA has no accepting
+// sink.
+// A CompiledDfa is never modified after construction and matching needs no
+// scratch space, so one instance can be shared by any number of threads.
+// MatchContext is empty and only exists so that CompiledDfa and
+// CompiledNfaEpsilon can be used interchangeably, e.g. by matchBatch().
+// checkStrings() matches many inputs at once by interleaving up to 16 of
+// them through the table, so the dependent load chains of separate inputs
+// overlap instead of each input waiting on its own load latency.  By default
+// lanes are advanced with plain loads; INTERLEAVE_AVX2 and INTERLEAVE_AVX512
+// use gathers instead, if a run time check finds the CPU supports them.
+// Gathers are not the default since they measured slower than 8 scalar
+// lanes on the machines tried so far; benchmark before switching.
+// An input can also be matched a piece at a time, for instance by
+// DfaStreamMatcher: startState() begins a match, advance() carries a state
+// over the next piece and isGoalState() reports whether everything fed so
+// far matches.  Only the current state is kept between pieces.
+// save() writes the tables to a versioned, checksummed file that holds no
+// pointers, and load() maps such a file read-only with mmap() and matches
+// straight from the mapping.  Processes loading the same file share one
+// physical copy of the tables through the page cache.  Copies of a
+// CompiledDfa share its tables instead of copying them.
+// checkStringParallel() splits one long input into chunks and matches them
+// on the threads of a WorkStealingPool.  Only the first chunk starts in a
+// known state, so every other chunk is run from all states at once; lanes
+// that reach the same state are merged, which in practice leaves one lane
+// after a few dozen bytes.  Each chunk so yields its state transfer
+// function, and composing them in order gives the exact final state.
+// A build with -DFA_ENABLE_STATS counts the work done by matching in a
+// DfaStats, read with statistics(); see EngineStats.h.  The counters are
+// atomic, so a shared instance still needs no locking.
+// Public methods:
+//    checkString() x4
+//    checkStrings()
+//    checkStringParallel() x2
+//    save()
+//    load()
+//    size()
+//    classes()
+//    classOf()
+//    startState()
+//    advance()
+//    isDeadState()
+//    isAcceptState()
+//    isDecidedState()
+//    isGoalState()
+//    nextState()
+//    statistics()
+//    resetStatistics()
+// Private methods:
+//    build()
+//    mergeDecidedStates()
+//    compressAlphabet()
+//    speculate()
+//    fileLayout()
+//    checksum()
 //    isMatch()
-// Only four members:
+//    interleave()
+//    advanceScalar()
+//    advanceAvx2()
+//    advanceAvx512()
+// Members:
 //    start
-//    key
-//    stateTransitionMap
-//    goalNodes
+//    acceptState
+//    stateCount
+//    classCount
+//    byteClass
+//    transitionTable
+//    goalBitmap
+//    storage
+//    stats
 //------------------------------------------------------------------------------
 class CompiledDfa
 {
    public:
+      //Scratch space for checkString() - a DFA needs none
+      struct MatchContext {};
+
+      //Lane engine used by checkStrings()
+      enum InterleaveMode {INTERLEAVE_AUTO, INTERLEAVE_SCALAR,
+         INTERLEAVE_AVX2, INTERLEAVE_AVX512};
+
       //Constructor
-      CompiledDfa(FiniteStateMachine finStMch);
+      CompiledDfa(const FiniteStateMachine& finStMch, bool minimize = false)
+         : CompiledDfa(CompactStateMachine(finStMch), minimize) {}
+
+      //Constructor from the contiguous representation
+      CompiledDfa(const CompactStateMachine& finStMch, bool minimize = false);
+
+      //Constructor that takes finStMch over and releases it once it is read
+      CompiledDfa(CompactStateMachine&& finStMch, bool minimize = false);
 
       //Destructor - key word 'new' is not used.
       ~CompiledDfa(){}
 
       //Returns value of isMatch()
-      inline bool checkString(string inputString)
-         {return isMatch(inputString, 0, start);}
+      inline bool checkString(string_view inputString) const
+         {return isMatch(inputString.data(), inputString.size());}
+
+      //Returns value of isMatch() for a raw byte span
+      inline bool checkString(const char* input, size_t length) const
+         {return isMatch(input, length);}
+
+      //Returns value of isMatch() - context is unused
+      inline bool checkString(string_view inputString, MatchContext&) const
+         {return isMatch(inputString.data(), inputString.size());}
+
+      //Returns value of isMatch() for a raw byte span - context is unused
+      inline bool checkString(const char* input, size_t length,
+         MatchContext&) const
+         {return isMatch(input, length);}
+
+      //Sets results[i] to checkString(inputs[i]) for every i < count.
+      //An engine the CPU does not support falls back to INTERLEAVE_SCALAR,
+      //as does INTERLEAVE_AUTO.
+      void checkStrings(const string_view* inputs, size_t count, bool* results,
+         InterleaveMode mode = INTERLEAVE_AUTO) const;
+
+      //Number of dense states, DEAD_STATE included
+      inline int size(void) const {return stateCount;}
+
+      //Number of byte classes, the columns of the transition table
+      inline int classes(void) const {return classCount;}
+
+      //Byte class of inputChar; bytes of one class lead every state alike
+      inline int classOf(unsigned char inputChar) const
+         {return byteClass[inputChar];}
+
+      //Returns the dense state a piecewise match starts in
+      inline int startState(void) const {return start;}
+
+      //Returns the dense state reached from state over the next input piece
+      int advance(int state, const char* input, size_t length) const;
+
+      //Returns true if no further input can lead state to a goal node
+      inline bool isDeadState(int state) const {return state == DEAD_STATE;}
+
+      //Returns true if every further input leaves state in a goal node
+      inline bool isAcceptState(int state) const
+         {return state == acceptState && state != DEAD_STATE;}
+
+      //Returns true if no further input can change whether state matches
+      inline bool isDecidedState(int state) const
+         {return state <= acceptState;}
+
+      //Returns true if the dense state is a goal node
+      inline bool isGoalState(int state) const
+         {return (goalBitmap[state >> 6] >> (state & 63)) & 1;}
+
+      //Returns the dense state reached from state on inputChar
+      inline int nextState(int state, unsigned char inputChar) const
+         {return transitionTable[state * classCount + byteClass[inputChar]];}
+
+      //Returns checkString(inputString), matching chunks on pool's threads
+      inline bool checkStringParallel(string_view inputString,
+         WorkStealingPool& pool) const
+         {return checkStringParallel(inputString.data(), inputString.size(),
+            pool);}
+
+      //Returns checkString(input, length), matching chunks on pool's threads
+      bool checkStringParallel(const char* input, size_t length,
+         WorkStealingPool& pool) const;
+
+      //Writes the tables to path, false if the file could not be written
+      bool save(const string& path) const;
+
+      //Maps a file written by save(), nullptr if it is missing or invalid.
+      //verify also checks the checksum and every table entry, which reads
+      //the whole file; only skip it for files from a trusted source.
+      static unique_ptr<CompiledDfa> load(const string& path,
+         bool verify = true);
+
+      //Counters of the matching done so far, all zero without FA_ENABLE_STATS
+      inline const DfaStats& statistics(void) const {return stats;}
+
+      //Sets the counters back to zero
+      inline void resetStatistics(void) const {stats.reset();}
 
    private:
-      CompiledDfa(); //no default constructor
+      CompiledDfa(); //no public default constructor, used by load()
+
+//------------------------------------------------------------------------------
+// struct TableStorage
+// Owns the tables of a CompiledDfa built from a FiniteStateMachine.  A loaded
+// CompiledDfa points into its file mapping instead.
+//------------------------------------------------------------------------------
+      struct TableStorage
+      {
+         vector<unsigned char> byteClass;
+         vector<int> transitionTable;
+         vector<uint64_t> goalBitmap;
+      };
+
+//------------------------------------------------------------------------------
+// struct StateTransfer
+// Result of running one chunk of input from every state: the chunk takes
+// state s to finalStates[laneOf[s]].
+//------------------------------------------------------------------------------
+      struct StateTransfer
+      {
+         vector<int> laneOf;
+         vector<int> finalStates;
+      };
+
+//------------------------------------------------------------------------------
+// struct FileHeader
+// First bytes of a file written by save().  All fields are in the byte order
+// of the machine that wrote the file, recorded in byteOrder so a machine of
+// the other order rejects it.  Each table starts at its offset from the
+// start of the file, aligned to FILE_ALIGNMENT:
+//    classOffset - ALPHABET_SIZE unsigned chars, byteClass
+//    tableOffset - stateCount x classCount ints, transitionTable
+//    goalOffset  - (stateCount + 63) / 64 uint64_ts, goalBitmap
+// checksum is the FNV-1a hash of every byte after the header, padding
+// included.  Version 2 replaced a reserved field, always zero, with
+// acceptState.  Version 1 files are rejected rather than loaded as having no
+// accepting sink, since their states were numbered without one; save them
+// again from the machine they were built from.
+//------------------------------------------------------------------------------
+      struct FileHeader
+      {
+         char magic[8];
+         uint32_t version;
+         uint32_t byteOrder;
+         int32_t start;
+         int32_t stateCount;
+         int32_t classCount;
+         int32_t acceptState;
+         uint64_t classOffset;
+         uint64_t tableOffset;
+         uint64_t goalOffset;
+         uint64_t fileSize;
+         uint64_t checksum;
+      };
+
+      static constexpr int DEAD_STATE = 0;       //Dense index of the sink state
+      static constexpr int ACCEPT_STATE = 1;     //Accepting sink, if any
+      static constexpr int ALPHABET_SIZE = 256;  //Number of byte values
+      //Longest run of bytes advanced by checkStrings() between lane checks
+      static constexpr size_t INTERLEAVE_BLOCK = 64;
+      //Bytes all lanes of speculate() advance between merges
+      static constexpr size_t SPECULATE_BLOCK = 256;
+      //Shortest chunk checkStringParallel() splits into, and the shortest
+      //per DFA state, so running a chunk from every state stays cheap
+      static constexpr size_t MIN_PARALLEL_CHUNK = size_t(1) << 20;
+      static constexpr size_t PARALLEL_CHUNK_PER_STATE = 256;
+      static constexpr uint32_t FILE_VERSION = 2;         //save() format
+      static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+      static constexpr size_t FILE_ALIGNMENT = 64;        //Table alignment
+
+      int start;           //Dense index of the Start Node
+      int acceptState;     //ACCEPT_STATE, or DEAD_STATE if there is none
+      int stateCount;      //Number of rows in transitionTable
+      int classCount;      //Number of columns in transitionTable
+      //Byte class of every byte value
+      const unsigned char* byteClass;
+      //Flat table of next-state indices, row-major by state
+      const int* transitionTable;
+      //One bit per dense state, set for goal nodes
+      const uint64_t* goalBitmap;
+      //Keeps what the three tables point into alive: a TableStorage, or the
+      //file mapping of a loaded CompiledDfa
+      shared_ptr<const void> storage;
+      //Matching statistics, updated by const matching methods
+      mutable DfaStats stats;
+
+      //Fills in the tables from finStMch
+      void build(const CompactStateMachine& finStMch);
+
+      //Merges dead states and accepting sinks of a full width table
+      void mergeDecidedStates(vector<int>& byteTable, vector<char>& goals);
+
+      //Narrows a full width table to byte classes
+      void compressAlphabet(const vector<int>& byteTable,
+         TableStorage& tables);
+
+      //Runs one chunk of input from every state
+      void speculate(const char* input, size_t length,
+         StateTransfer& transfer) const;
+
+      //Fills in the table offsets and file size of header from its counts
+      static void fileLayout(FileHeader& header);
+
+      //FNV-1a hash of length bytes
+      static uint64_t checksum(const unsigned char* bytes, size_t length);
+
+      //Returns true of input matches the DFA, false otherwise
+      bool isMatch(const char* input, size_t length) const;
+
+      //Runs checkStrings() on WIDTH lanes, each block advanced by advance
+      template<int WIDTH, class Advance>
+      void interleave(const string_view* inputs, size_t count, bool* results,
+         Advance advance) const;
+
+      //Advances every lane by length bytes with scalar loads
+      template<int WIDTH>
+      static void advanceScalar(const int* table,
+         const unsigned char* byteClass, int classCount,
+         const unsigned char* const* lanes, int* states, size_t length);
 
-      int start;           //Start Node
-      string key;          //Key for stateTransitionMap
-      //Map of transitions
-      unordered_map<string, int> stateTransitionMap;
-      //set of goal nodes
-      unordered_set<int> goalNodes;
+      //Advances 8 lanes by length bytes with AVX2 gathers
+      static void advanceAvx2(const int* table,
+         const unsigned char* byteClass, int classCount,
+         const unsigned char* const* lanes, int* states, size_t length);
 
-      //Returns true of inputString matches the DFA, false otherwise
-      bool isMatch(string inputString, unsigned posInString, int curState);
+      //Advances 16 lanes by length bytes with AVX-512 gathers
+      static void advanceAvx512(const int* table,
+         const unsigned char* byteClass, int classCount,
+         const unsigned char* const* lanes, int* states, size_t length);
 };
 
 #endif // COMPILEDDFA_H
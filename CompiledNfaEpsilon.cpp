@@ -7,150 +7,421 @@
 // or translates a FiniteStateMachine in NFA format into a
 // FiniteStateMachine in DFA format.
 // Contains Implementations for:
-//    isMatch()
-//    initializeDestinationSet() x2
-//    translateToDFA()  x2
+//    Constructor x3
+//    compileBitParallel()
+//    isMatchBitParallel()
+//    isMatchNodeSet()
+//    startMatch()
+//    advanceMatch()
+//    isAccepted()
+//    advanceBitParallel()
+//    advanceNodeSet()
+//    fillDestinationSet()
+//    translate()
+//    translateParallel()
+//    makeParallelTranslation()
+//    expandNodeSet()
+//    internNodeSet()
+//    numberLevel()
 //    initializeTranslator()
-//    depthFirstSearchEpsilon()
 //    makeLanguage()
 //    buildDestinationSetWithTran()
 //    makeTranslation()
 //    translateTransition()
 //    makeNewDfaTransition()
-//    setUnion()
 //    isGoalNode()
-//    fillEpsilonClosure()
-//    fillDestSetFromSrcSet()
 //    fillDestSetFromTransitions()
 //    checkIfSetContainsGoalNode()
+//    epsilonFreeIndex() x3
 //------------------------------------------------------------------------------
 #include "CompiledNfaEpsilon.h"
+#include <algorithm>
 
 //------------------------------------------------------------------------------
-// isMatch(string inputString, unsigned posInString, int curState)
-// Declares and assigns inputChar and destinationNodeSet.
-// If posInString is at the end of inputString, return true if
-// destinationNodeSet contains a goal node - false otherwise.
-// If posInString is not at the end of inputString, check each node in
-// destinationNodeSet recursively.  If no node in destinationNodeSet
-// is a match, return false.
+// Constructs a CompiledNfaEpsilon based on a FiniteStateMachine formatted for
+// NFA-EPSILON.  The transition index is always built, of the machine with
+// its epsilon transitions eliminated; the bit parallel tables are only built
+// when they are used.
 // Calls:
-//    initializeDestinationSet()
-//    checkIfSetContainsGoalNode()
-//    isMatch()
+//    epsilonFreeIndex()
+//    compileBitParallel()
 //------------------------------------------------------------------------------
-bool CompiledNfaEpsilon::isMatch(string inputString, unsigned posInString,
-   int curState)
+CompiledNfaEpsilon::CompiledNfaEpsilon(const FiniteStateMachine& fsm,
+   MatchMode mode)
+: index(epsilonFreeIndex(fsm)), matchMode(mode), stateCount(0), maskWords(0)
 {
-   char inputChar = inputString[posInString];
-   unordered_set<int> destinationNodeSet =
-      initializeDestinationSet(inputChar, curState);
+   if(matchMode == BIT_PARALLEL)
+   {
+      compileBitParallel();
+   }
+}
 
-   if(posInString == inputString.length() - 1)
+//------------------------------------------------------------------------------
+// Constructs a CompiledNfaEpsilon based on a CompactStateMachine formatted for
+// NFA-EPSILON, exactly as the FiniteStateMachine constructor does.
+// Calls:
+//    epsilonFreeIndex()
+//    compileBitParallel()
+//------------------------------------------------------------------------------
+CompiledNfaEpsilon::CompiledNfaEpsilon(const CompactStateMachine& fsm,
+   MatchMode mode)
+: index(epsilonFreeIndex(fsm)), matchMode(mode), stateCount(0), maskWords(0)
+{
+   if(matchMode == BIT_PARALLEL)
    {
-      return checkIfSetContainsGoalNode(destinationNodeSet);
+      compileBitParallel();
    }
+}
 
-   for(int node : destinationNodeSet)
+//------------------------------------------------------------------------------
+// Constructs a CompiledNfaEpsilon from a CompactStateMachine it takes over,
+// which is released as soon as it is indexed instead of being held until
+// the caller's copy goes away.
+// Calls:
+//    epsilonFreeIndex()
+//    compileBitParallel()
+//------------------------------------------------------------------------------
+CompiledNfaEpsilon::CompiledNfaEpsilon(CompactStateMachine&& fsm,
+   MatchMode mode)
+: index(epsilonFreeIndex(move(fsm))), matchMode(mode), stateCount(0),
+  maskWords(0)
+{
+   if(matchMode == BIT_PARALLEL)
    {
-      if(isMatch(inputString, posInString + 1, node))
+      compileBitParallel();
+   }
+}
+
+//------------------------------------------------------------------------------
+// compileBitParallel()
+// Groups the edges of each dense node in index by char and lists the
+// destinations of each group; index has no epsilon transitions, so
+// matching never has to follow one.  Dense numbers are shared with index.
+// A one word NFA with few enough distinct chars also gets followTable: for
+// every char class, byte c of the active set and value v of that byte, the
+// union of the destination sets of the nodes 8c + bit, for every bit set
+// in v.
+//------------------------------------------------------------------------------
+void CompiledNfaEpsilon::compileBitParallel(void)
+{
+   stateCount = index.size();
+   maskWords = (stateCount + 63) / 64;
+
+   int denseStart = index.startNode();
+   startMask.assign(maskWords, 0);
+   startMask[denseStart >> 6] |= uint64_t(1) << (denseStart & 63);
+   goalMask.assign(maskWords, 0);
+   for(int node = 0; node < stateCount; ++node)
+   {
+      if(index.isGoal(node))
       {
-         return true;
+         goalMask[node >> 6] |= uint64_t(1) << (node & 63);
+      }
+   }
+
+   stepOffsets.assign(1, 0);
+   for(int node = 0; node < stateCount; ++node)
+   {
+      for(int edge = index.edgesBegin(node); edge < index.edgesEnd(node);
+         ++edge)
+      {
+         char symbol = index.edgeSymbol(edge);
+         if(edge == index.edgesBegin(node) ||
+            index.edgeSymbol(edge - 1) != symbol)
+         {
+            stepChars.push_back(static_cast<unsigned char>(symbol));
+            stepDestOffsets.push_back(static_cast<int>(stepDests.size()));
+         }
+         stepDests.push_back(index.edgeDestination(edge));
+      }
+      stepOffsets.push_back(static_cast<int>(stepChars.size()));
+   }
+   stepDestOffsets.push_back(static_cast<int>(stepDests.size()));
+
+   if(maskWords != 1)
+   {
+      return;
+   }
+   vector<unsigned char> classes(256, 0);
+   int classCount = 1;
+   for(unsigned char symbol : stepChars)
+   {
+      if(classes[symbol] == 0)
+      {
+         if(classCount == MAX_FOLLOW_CLASSES)
+         {
+            return;
+         }
+         classes[symbol] = static_cast<unsigned char>(classCount++);
+      }
+   }
+   charClass.swap(classes);
+   followTable.assign(classCount * FOLLOW_CHUNKS * 256, 0);
+   for(int node = 0; node < stateCount; ++node)
+   {
+      for(int i = stepOffsets[node]; i < stepOffsets[node + 1]; ++i)
+      {
+         uint64_t reached = 0;
+         for(int d = stepDestOffsets[i]; d < stepDestOffsets[i + 1]; ++d)
+         {
+            reached |= uint64_t(1) << stepDests[d];
+         }
+         uint64_t* table = &followTable[(charClass[stepChars[i]] *
+            FOLLOW_CHUNKS + (node >> 3)) * 256];
+         for(int value = 0; value < 256; ++value)
+         {
+            if(value & (1 << (node & 7)))
+            {
+               table[value] |= reached;
+            }
+         }
       }
    }
-   return false;
 }
 
 //------------------------------------------------------------------------------
-// initializeDestinationSet(char& inputChar, int& curState)
-// Declare and Assign epsilon closure and destinationNodeSet.
-// Return destinationNodeSet
+// isMatchBitParallel(const char* input, size_t length, MatchContext& context)
+// Thompson simulation over bit masks.  An NFA with a followTable keeps the
+// whole active set in one register, never touches context and steps it
+// with followWord(); any other keeps its active sets in context.
 // Calls:
-//    fillEpsilonClosure()
-//    fillDestSetFromSrcSet()
-//    fillDestSetFromTransitions()
+//    followWord()
+//    startMatch()
+//    advanceBitParallel()
+//    isAccepted()
 //------------------------------------------------------------------------------
-unordered_set<int> CompiledNfaEpsilon::initializeDestinationSet(char& inputChar,
-   int& curState)
+bool CompiledNfaEpsilon::isMatchBitParallel(const char* input, size_t length,
+   MatchContext& context) const
 {
-   unordered_set<int> epsilonClosure;
-   fillEpsilonClosure(curState, epsilonClosure);
-   unordered_set<int> destinationNodeSet;
-   fillDestSetFromSrcSet(epsilonClosure, inputChar, destinationNodeSet);
-   fillDestSetFromTransitions(curState, inputChar, destinationNodeSet);
-   return destinationNodeSet;
+   if(!followTable.empty())
+   {
+      uint64_t curStates = startMask[0];
+      size_t pos = 0;
+      for(; pos < length && curStates; ++pos)
+      {
+         curStates = followWord(curStates,
+            static_cast<unsigned char>(input[pos]));
+         matchStats.recordActiveSet(__builtin_popcountll(curStates));
+      }
+      bool accepted = (curStates & goalMask[0]) != 0;
+      matchStats.recordWalk(length, pos, pos < length);
+      matchStats.recordMatch(accepted);
+      return accepted;
+   }
+
+   startMatch(context);
+   bool accepted = advanceBitParallel(input, length, context) &&
+      isAccepted(context);
+   matchStats.recordMatch(accepted);
+   return accepted;
 }
 
 //------------------------------------------------------------------------------
-// depthFirstSearchEpsilon(list<Transition>& transitions, int& node,
-// unordered_set<int>& closure)
-// Conducts a depth first search in the transitions list for nods reachable
-// with on epsilon.
-// NB: This version of the function does NOT use the member translator.
+// isMatchNodeSet(const char* input, size_t length, MatchContext& context)
+// Advances the whole set of active nodes one input character at a time
+// instead of recursing once per character, so input is never copied and
+// long inputs cannot overflow the stack.  Returns false as soon as the
+// active set empties.  The node sets live in context.
 // Calls:
-//    depthFirstSearchEpsilon()
+//    startMatch()
+//    advanceNodeSet()
+//    isAccepted()
 //------------------------------------------------------------------------------
-void CompiledNfaEpsilon::depthFirstSearchEpsilon(list<Transition>& transitions,
-   int& node, unordered_set<int>& closure)
+bool CompiledNfaEpsilon::isMatchNodeSet(const char* input, size_t length,
+   MatchContext& context) const
 {
-   for(auto tran : transitions)
+   startMatch(context);
+   bool accepted = advanceNodeSet(input, length, context) &&
+      isAccepted(context);
+   matchStats.recordMatch(accepted);
+   return accepted;
+}
+
+//------------------------------------------------------------------------------
+// startMatch(MatchContext& context)
+// Puts context back at the start of a new input: the active set becomes the
+// start node.
+//------------------------------------------------------------------------------
+void CompiledNfaEpsilon::startMatch(MatchContext& context) const
+{
+   if(matchMode == BIT_PARALLEL)
+   {
+      context.curStates.assign(startMask.begin(), startMask.end());
+      context.nextStates.resize(maskWords);
+   }
+   else
    {
-      if(tran.source == node && tran.transitionChar == EPSILON)
+      context.curNodes.clear();
+      context.curNodes.emplace(index.nodeOf(index.startNode()));
+   }
+}
+
+//------------------------------------------------------------------------------
+// advanceMatch(MatchContext& context, const char* input, size_t length)
+// Advances the active set in context over input, which may be any piece of
+// a longer input; the pieces need not line up with anything.  Returns false
+// once the active set is empty, after which no further input can match.
+// Calls:
+//    advanceBitParallel()
+//    advanceNodeSet()
+//------------------------------------------------------------------------------
+bool CompiledNfaEpsilon::advanceMatch(MatchContext& context,
+   const char* input, size_t length) const
+{
+   return (matchMode == BIT_PARALLEL) ?
+      advanceBitParallel(input, length, context) :
+      advanceNodeSet(input, length, context);
+}
+
+//------------------------------------------------------------------------------
+// isAccepted(MatchContext& context)
+// Returns true if the active set in context holds a goal node, that is if
+// the input fed to context since startMatch() matches.
+// Calls:
+//    checkIfSetContainsGoalNode()
+//------------------------------------------------------------------------------
+bool CompiledNfaEpsilon::isAccepted(MatchContext& context) const
+{
+   if(matchMode == BIT_PARALLEL)
+   {
+      for(int w = 0; w < maskWords; ++w)
       {
-         closure.emplace(tran.destination);
-         depthFirstSearchEpsilon(transitions, tran.destination, closure);
+         if(context.curStates[w] & goalMask[w])
+         {
+            return true;
+         }
       }
+      return false;
    }
+
+   return checkIfSetContainsGoalNode(context.curNodes);
 }
 
 //------------------------------------------------------------------------------
-// depthFirstSearchEpsilon(int& node, unordered_set<int>& closure)
-// Conducts a depth first search in the transitions list for nods reachable
-// with on epsilon.
-// NB: This version of the function DOES use the member translator.
+// advanceBitParallel(const char* input, size_t length, MatchContext& context)
+// Advances the bit mask active set in context.curStates over input, using
+// context.nextStates as the second buffer.  With a followTable each char is
+// one followWord(); otherwise each active node binary searches its chars
+// and sets the bit of each destination, so no step costs more than the
+// active nodes and the edges they follow plus clearing nextStates.
+// Returns false as soon as no node is active.
 // Calls:
-//    depthFirstSearchEpsilon()
+//    followWord()
 //------------------------------------------------------------------------------
-void CompiledNfaEpsilon::depthFirstSearchEpsilon(int& node,
-   unordered_set<int>& closure)
+bool CompiledNfaEpsilon::advanceBitParallel(const char* input, size_t length,
+   MatchContext& context) const
 {
-   for(Transition tran : translator.nfae.transitions)
+   vector<uint64_t>& curStates = context.curStates;
+   vector<uint64_t>& nextStates = context.nextStates;
+   const unsigned char* chars = stepChars.data();
+   for(size_t pos = 0; pos < length; ++pos)
    {
-      if(tran.source == node && tran.transitionChar == EPSILON)
+      unsigned char inputChar = static_cast<unsigned char>(input[pos]);
+      bool anyActive = false;
+      if(!followTable.empty())
       {
-         closure.emplace(tran.destination);
-         depthFirstSearchEpsilon(tran.destination, closure);
+         curStates[0] = followWord(curStates[0], inputChar);
+         anyActive = curStates[0] != 0;
+      }
+      else
+      {
+         fill(nextStates.begin(), nextStates.end(), 0);
+         for(int w = 0; w < maskWords; ++w)
+         {
+            for(uint64_t bits = curStates[w]; bits; bits &= bits - 1)
+            {
+               int node = (w << 6) | __builtin_ctzll(bits);
+               const unsigned char* first = chars + stepOffsets[node];
+               const unsigned char* last = chars + stepOffsets[node + 1];
+               const unsigned char* found = lower_bound(first, last,
+                  inputChar);
+               if(found == last || *found != inputChar)
+               {
+                  continue;
+               }
+               int group = static_cast<int>(found - chars);
+               for(int d = stepDestOffsets[group];
+                  d < stepDestOffsets[group + 1]; ++d)
+               {
+                  int dest = stepDests[d];
+                  nextStates[dest >> 6] |= uint64_t(1) << (dest & 63);
+               }
+               anyActive = true;
+            }
+         }
+         curStates.swap(nextStates);
+      }
+      if(STATS_ENABLED)
+      {
+         size_t activeNodes = 0;
+         for(int w = 0; w < maskWords; ++w)
+         {
+            activeNodes += __builtin_popcountll(curStates[w]);
+         }
+         matchStats.recordActiveSet(activeNodes);
+      }
+      if(!anyActive)
+      {
+         matchStats.recordWalk(length, pos + 1, pos + 1 < length);
+         return false;
       }
    }
+   matchStats.recordWalk(length, length, false);
+   return true;
 }
 
 //------------------------------------------------------------------------------
-// translateToDFA(FiniteStateMachine nfae)
-// // Translates the parameter nfae
-// Initializes translator
-// Derives language and epsilon closure
-// Associates epsilon closure with start node
-// Translates the nfae to a dfa
-// Returns dfa
+// advanceNodeSet(const char* input, size_t length, MatchContext& context)
+// Advances the unordered_set active set in context.curNodes over input,
+// using context.nextNodes as the second buffer.  Returns false as soon as
+// no node is active.
 // Calls:
-//    initializeTranslator()
-//    makeLanguage()
-//    makeTranslation()
+//    fillDestinationSet()
+//------------------------------------------------------------------------------
+bool CompiledNfaEpsilon::advanceNodeSet(const char* input, size_t length,
+   MatchContext& context) const
+{
+   unordered_set<int>& curStates = context.curNodes;
+   unordered_set<int>& nextStates = context.nextNodes;
+   for(size_t pos = 0; pos < length; ++pos)
+   {
+      char inputChar = input[pos];
+      nextStates.clear();
+      for(int node : curStates)
+      {
+         fillDestinationSet(inputChar, node, nextStates);
+      }
+      curStates.swap(nextStates);
+      matchStats.recordActiveSet(curStates.size());
+      if(curStates.empty())
+      {
+         matchStats.recordWalk(length, pos + 1, pos + 1 < length);
+         return false;
+      }
+   }
+   matchStats.recordWalk(length, length, false);
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// fillDestinationSet(char& inputChar, int& curState,
+// unordered_set<int>& destinationNodeSet)
+// Adds every node reachable from curState on inputChar to
+// destinationNodeSet.
+// Calls:
+//    fillDestSetFromTransitions()
 //------------------------------------------------------------------------------
-FiniteStateMachine CompiledNfaEpsilon::translateToDFA(FiniteStateMachine nfae)
+void CompiledNfaEpsilon::fillDestinationSet(char& inputChar, int& curState,
+   unordered_set<int>& destinationNodeSet) const
 {
-   initializeTranslator(nfae);
-   unordered_set<char> language = makeLanguage(nfae);
-   makeTranslation(language);
-   return translator.dfa;
+   fillDestSetFromTransitions(curState, inputChar, destinationNodeSet);
 }
 
 //------------------------------------------------------------------------------
-// translateToDFA(void)
-// Translates the member nfae
-// Initializes translator
-// Derives language and epsilon closure
-// Associates epsilon closure with start node
+// translate(const TransitionIndex& nfaeIndex)
+// Initializes a translator local to this call
+// Derives language
+// Associates the start node set with start node
 // Translates the nfae to a dfa
 // Returns dfa
 // Calls:
@@ -158,234 +429,372 @@ FiniteStateMachine CompiledNfaEpsilon::translateToDFA(FiniteStateMachine nfae)
 //    makeLanguage()
 //    makeTranslation()
 //------------------------------------------------------------------------------
-FiniteStateMachine CompiledNfaEpsilon::translateToDFA(void)
+CompactStateMachine CompiledNfaEpsilon::translate(
+   const TransitionIndex& nfaeIndex) const
 {
-   initializeTranslator(fsmNFA);
-   unordered_set<char> language = makeLanguage(fsmNFA);
-   makeTranslation(language);
-   return translator.dfa;
+   StatTimer timer;
+   Translator translator(nfaeIndex);
+   initializeTranslator(translator);
+   vector<char> language = makeLanguage(nfaeIndex);
+   makeTranslation(translator, language);
+   translationStats.recordTranslation(timer);
+   return move(translator.dfa);
 }
 
 //------------------------------------------------------------------------------
-// initializeTranslator(FiniteStateMachine nfae)
-// Initializes members of translator from nfae.
+// translateParallel(const TransitionIndex& nfaeIndex, WorkStealingPool& pool)
+// Translates the nfae with a parallel translator local to this call.  The
+// dfa is identical to the one translate(nfaeIndex) returns.
 // Calls:
-//    depthFirstSearchEpsilon()
+//    makeParallelTranslation()
 //------------------------------------------------------------------------------
-void CompiledNfaEpsilon::initializeTranslator(FiniteStateMachine nfae)
+CompactStateMachine CompiledNfaEpsilon::translateParallel(
+   const TransitionIndex& nfaeIndex, WorkStealingPool& pool) const
 {
-   translator.nfae = nfae;
-   translator.dfa.startNode = nfae.startNode;
-   auto nodeIt = nfae.goalNodes.find(nfae.startNode);
-   if(nodeIt != nfae.goalNodes.end())
-   {
-      translator.dfa.goalNodes.emplace(nfae.startNode);
-   }
-   translator.dfa.nodes.emplace(nfae.startNode);
-   unordered_set<int> epsilonClosure ({nfae.startNode});
-   depthFirstSearchEpsilon(nfae.startNode, epsilonClosure);
-   translator.nodeMapQueue.push(epsilonClosure, nfae.startNode);
+   StatTimer timer;
+   ParallelTranslator translator(nfaeIndex);
+   makeParallelTranslation(translator, pool);
+   translationStats.recordTranslation(timer);
+   return move(translator.dfa);
 }
 
 //------------------------------------------------------------------------------
-// makeLanguage(FiniteStateMachine& nfae)
-// Collects all unique transitionChar from nfae and returns the resulting
-// unordered_set<char>
+// makeParallelTranslation(ParallelTranslator& translator,
+// WorkStealingPool& pool)
+// Makes the set of the nfae start node dfa node 0, the first
+// frontier.  Each level then expands every frontier node set on
+// every symbol in parallel and numbers what it found serially; the sets
+// found become the next frontier, until a level finds nothing new.
+// Calls:
+//    makeLanguage()
+//    internNodeSet()
+//    isGoalNode()
+//    expandNodeSet()
+//    numberLevel()
 //------------------------------------------------------------------------------
-unordered_set<char> CompiledNfaEpsilon::makeLanguage(FiniteStateMachine& nfae)
+void CompiledNfaEpsilon::makeParallelTranslation(
+   ParallelTranslator& translator, WorkStealingPool& pool) const
 {
-   unordered_set<char> tmpLang;
-   for(Transition transition : nfae.transitions)
+   vector<char> language = makeLanguage(translator.nfaeIndex);
+
+   NodeSet startSet(1, translator.nfaeIndex.startNode());
+   bool isNew = false;
+   size_t startSize = startSet.size();
+   InternEntry* startEntry = internNodeSet(translator, startSet, 0, isNew);
+   translationStats.recordNodeSet(startSize, true);
+   startEntry->dfaId = translator.dfa.addNode();
+   translator.dfa.setStartNode(startEntry->dfaId);
+   if(isGoalNode(translator.nfaeIndex, *startEntry->nodeSet))
    {
-      tmpLang.emplace(transition.transitionChar);
+      translator.dfa.setGoal(startEntry->dfaId);
    }
-   return tmpLang;
-}
+   translator.frontier.assign(1, startEntry->nodeSet);
+   translator.frontierBase = 0;
 
-//------------------------------------------------------------------------------
-// buildDestinationSetWithTran(unordered_set<int>& destSet, char& symbol)
-// Conducts a breadth first search for nodes reachable on transitionChar symbol.
-//------------------------------------------------------------------------------
-void CompiledNfaEpsilon::buildDestinationSetWithTran(unordered_set<int>& destSet,
-   char& symbol)
-{
-   for(auto source : translator.nodeMapQueue.unmappedNodeSets.front())
+   while(!translator.frontier.empty())
    {
-      for(auto transition : translator.nfae.transitions)
+      size_t items = translator.frontier.size();
+      translator.targets.assign(items * language.size(), nullptr);
+      translator.created.assign(items, vector<InternEntry*>());
+      size_t grain = max<size_t>(1,
+         items / (pool.size() * LEVEL_TASKS_PER_WORKER));
+      pool.parallelFor(items, grain, [&](size_t begin, size_t end)
       {
-         if(transition.source == source && transition.transitionChar == symbol)
+         for(size_t item = begin; item < end; ++item)
          {
-            destSet.emplace(transition.destination);
+            expandNodeSet(translator, language, item);
          }
-      }
+      });
+      numberLevel(translator, language);
    }
 }
 
 //------------------------------------------------------------------------------
-// makeTranslation(unordered_set<char>& language)
-// Translates, breadth first, nfae to dfa.
+// expandNodeSet(ParallelTranslator& translator, const vector<char>& language,
+// size_t item)
+// Builds the destination set of frontier[item] on every symbol of
+// language, exactly as buildDestinationSetWithTran() does, and interns each
+// non-empty one.  Only writes the targets and created slots of item, so
+// items can be expanded concurrently.
 // Calls:
-//    translateTransition()
+//    sortNodeSet()
+//    internNodeSet()
 //------------------------------------------------------------------------------
-void CompiledNfaEpsilon::makeTranslation(unordered_set<char>& language)
+void CompiledNfaEpsilon::expandNodeSet(ParallelTranslator& translator,
+   const vector<char>& language, size_t item) const
 {
-   int dest = 0;
-   while(!translator.nodeMapQueue.empty())
+   StatTimer timer;
+   const TransitionIndex& nfaeIndex = translator.nfaeIndex;
+   const NodeSet& sourceSet = *translator.frontier[item];
+   for(size_t symbol = 0; symbol < language.size(); ++symbol)
    {
-      for(char symbol : language)
+      NodeSet destSet;
+      for(int source : sourceSet)
       {
-         translateTransition(dest, symbol);
+         TransitionIndex::NodeRange dests =
+            nfaeIndex.destinations(source, language[symbol]);
+         destSet.insert(destSet.end(), dests.first, dests.second);
       }
-      translator.nodeMapQueue.pop();
+      if(destSet.empty())
+      {
+         translationStats.recordNodeSet(0, false);
+         continue;
+      }
+      sortNodeSet(destSet);
+
+      size_t target = item * language.size() + symbol;
+      size_t setSize = destSet.size();
+      bool isNew = false;
+      InternEntry* entry = internNodeSet(translator, destSet, target, isNew);
+      translationStats.recordNodeSet(setSize, isNew);
+      translator.targets[target] = entry;
+      if(isNew)
+      {
+         translator.created[item].push_back(entry);
+      }
+   }
+   translationStats.recordExpansion(timer);
+}
+
+//------------------------------------------------------------------------------
+// internNodeSet(ParallelTranslator& translator, NodeSet& nodeSet,
+// uint64_t discovery, bool& isNew)
+// Looks nodeSet up in its shard, under the shard's lock, and adds it with no
+// dfa node yet if it is not there; isNew tells which.  A set that is still
+// waiting for its number keeps the lowest discovery position of all the
+// threads that reached it, which is where a serial translation would have
+// found it first.  nodeSet is moved into the table if it is new.
+//------------------------------------------------------------------------------
+CompiledNfaEpsilon::InternEntry* CompiledNfaEpsilon::internNodeSet(
+   ParallelTranslator& translator, NodeSet& nodeSet, uint64_t discovery,
+   bool& isNew) const
+{
+   InternShard& shard =
+      translator.shards[NodeSetHash()(nodeSet) % INTERN_SHARDS];
+   lock_guard<mutex> guard(shard.lock);
+   auto found = shard.ids.try_emplace(move(nodeSet),
+      InternEntry{-1, discovery, nullptr});
+   InternEntry& entry = found.first->second;
+   isNew = found.second;
+   if(isNew)
+   {
+      entry.nodeSet = &found.first->first;
+   }
+   else if(entry.dfaId < 0 && discovery < entry.discovery)
+   {
+      entry.discovery = discovery;
    }
+   return &entry;
 }
 
 //------------------------------------------------------------------------------
-// translateTransition(int& dest, char& symbol)
-// Declares and assigns a set of destination nodes in nfae reachable on
-// transitionChar suymbol.  If destSet is not empty but the symbol is EPSILON
-// the source set is made to be the union of the source set and the destination
-// set.  If symbol is not EPSILON, a new dfa transition is made,  Furthermore,
-// if the source and destination sets are dissimilar we check for goal node
-// status (and update dfa.goalNodes appropriately), add the new dfa destination
-// to dfa.nodes and push the new destination set and destination onto
-// nodeMapQueue.
+// numberLevel(ParallelTranslator& translator, const vector<char>& language)
+// Gives the sets created by the level just expanded the next dfa nodes in
+// order of discovery, which is the order translateToDFA() numbers them in,
+// and checks each for goal nodes.  Then adds the level's dfa transitions,
+// source by source and symbol by symbol as translateToDFA() does, and makes
+// the new sets the next frontier.
 // Calls:
-//    buildDestinationSetWithTran()
-//    setUnion()
-//    makeNewDfaTransition()
 //    isGoalNode()
-//    nodeMapQueue.push()
 //------------------------------------------------------------------------------
-void CompiledNfaEpsilon::translateTransition(int& dest, char& symbol)
+void CompiledNfaEpsilon::numberLevel(ParallelTranslator& translator,
+   const vector<char>& language) const
 {
-   unordered_set<int> destSet;
-   buildDestinationSetWithTran(destSet, symbol);
-   if(destSet.size() == 0) { return; }
+   vector<InternEntry*> found;
+   for(const vector<InternEntry*>& itemFound : translator.created)
+   {
+      found.insert(found.end(), itemFound.begin(), itemFound.end());
+   }
+   sort(found.begin(), found.end(),
+      [](const InternEntry* left, const InternEntry* right)
+      {return left->discovery < right->discovery;});
 
-   if(symbol == EPSILON)
+   int nextId = translator.frontierBase +
+      static_cast<int>(translator.frontier.size());
+   vector<const NodeSet*> nextFrontier;
+   nextFrontier.reserve(found.size());
+   for(InternEntry* entry : found)
    {
-      translator.nodeMapQueue.unmappedNodeSets.front() =
-         setUnion(translator.nodeMapQueue.unmappedNodeSets.front(), destSet);
+      entry->dfaId = nextId++;
+      translator.dfa.addNode();
+      if(isGoalNode(translator.nfaeIndex, *entry->nodeSet))
+      {
+         translator.dfa.setGoal(entry->dfaId);
+      }
+      nextFrontier.push_back(entry->nodeSet);
    }
-   else
+
+   for(size_t item = 0; item < translator.frontier.size(); ++item)
    {
-      makeNewDfaTransition(symbol, destSet, dest);
-      if(destSet != translator.nodeMapQueue.unmappedNodeSets.front())
+      for(size_t symbol = 0; symbol < language.size(); ++symbol)
       {
-         if(isGoalNode(destSet, translator.nfae))
+         const InternEntry* target =
+            translator.targets[item * language.size() + symbol];
+         if(target)
          {
-            translator.dfa.goalNodes.emplace(dest);
+            translator.dfa.addTransition(
+               translator.frontierBase + static_cast<int>(item),
+               language[symbol], target->dfaId);
          }
-         translator.dfa.nodes.emplace(dest);
-         translator.nodeMapQueue.push(destSet, dest);
       }
    }
+   translator.frontierBase = nextId - static_cast<int>(found.size());
+   translator.frontier.swap(nextFrontier);
 }
 
 //------------------------------------------------------------------------------
-// makeNewDfaTransition(char& symbol, unordered_set<int> destSet, int& dest)
-// Creates a Transition from translator.nodeMapQueue.unmappedNodes.front(),
-// symbol and dest. Then we add this Transition to translator.dfa.transitions
-// NB: if the source node set is identical to the destination node set we do
-// not increment the destination node.
+// initializeTranslator(Translator& translator)
+// Initializes the members of a fresh translator from its nfae: the set of
+// the start node becomes dfa node 0.
+// Calls:
+//    isGoalNode()
 //------------------------------------------------------------------------------
-void CompiledNfaEpsilon::makeNewDfaTransition(char& symbol,
-   unordered_set<int> destSet, int& dest)
+void CompiledNfaEpsilon::initializeTranslator(Translator& translator) const
 {
-   Transition tran;
-   tran.source = translator.nodeMapQueue.unmappedNodes.front();
-   tran.transitionChar = symbol;
-   (translator.nodeMapQueue.unmappedNodeSets.front() == destSet) ?
-      tran.destination = translator.nodeMapQueue.unmappedNodes.front() :
-      tran.destination = ++dest;
-   translator.dfa.transitions.push_back(tran);
+   NodeSet startSet(1, translator.nfaeIndex.startNode());
+
+   int startDfa = translator.dfa.addNode();
+   translator.dfa.setStartNode(startDfa);
+   if(isGoalNode(translator.nfaeIndex, startSet))
+   {
+      translator.dfa.setGoal(startDfa);
+   }
+   translator.dfaSets.intern(startSet);
+   translationStats.recordNodeSet(startSet.size(), true);
+   translator.nodeMapQueue.push(startSet, startDfa);
 }
 
 //------------------------------------------------------------------------------
-// setUnion(unordered_set<int>& setA, unordered_set<int>& setB)
-// Returns the union of setA and setB.
-// NB: a copy of setA is returned so that allocation exceptions are avoided.
+// makeLanguage(const TransitionIndex& nfaeIndex)
+// Collects all unique edge symbols of nfaeIndex and returns them sorted, so
+// dfa nodes are numbered the same way on every run.
 //------------------------------------------------------------------------------
-unordered_set<int>& CompiledNfaEpsilon::setUnion(unordered_set<int>& setA,
-   unordered_set<int>& setB)
+vector<char> CompiledNfaEpsilon::makeLanguage(
+   const TransitionIndex& nfaeIndex) const
 {
-   unordered_set<int> tmpSetA = setA;
-   for(auto i : setB)
+   vector<char> tmpLang;
+   int edgeCount = nfaeIndex.edgesEnd(nfaeIndex.size() - 1);
+   for(int edge = 0; edge < edgeCount; ++edge)
    {
-      tmpSetA.emplace(i);
+      tmpLang.push_back(nfaeIndex.edgeSymbol(edge));
    }
-   return tmpSetA;
+   sort(tmpLang.begin(), tmpLang.end());
+   tmpLang.erase(unique(tmpLang.begin(), tmpLang.end()), tmpLang.end());
+   return tmpLang;
 }
 
 //------------------------------------------------------------------------------
-// isGoalNode(unordered_set<int>& destinationSet, FiniteStateMachine& nfae)
-// Returns true if any node destinationSet is also in nfae.goalNodes, returns
-// false otherwise.  In other words, returns true if the intersection between
-// these two sets is not empty, false otherwise.
+// buildDestinationSetWithTran(Translator& translator, NodeSet& destSet,
+// char& symbol)
+// Collects the nodes reachable on transitionChar symbol from the node set at
+// the front of the queue, sorted and without duplicates.  Each source node
+// only visits its own edges labelled symbol.
+// Calls:
+//    sortNodeSet()
 //------------------------------------------------------------------------------
-bool CompiledNfaEpsilon::isGoalNode(unordered_set<int>& destinationSet,
-   FiniteStateMachine& nfae)
+void CompiledNfaEpsilon::buildDestinationSetWithTran(Translator& translator,
+   NodeSet& destSet, char& symbol) const
 {
-   bool isGoal = false;
-   for(int node : destinationSet)
+   const TransitionIndex& nfaeIndex = translator.nfaeIndex;
+   for(int source : translator.nodeMapQueue.unmappedNodeSets.front())
    {
-      auto nodeIterator = nfae.goalNodes.find(node);
-      if(nodeIterator != nfae.goalNodes.end())
-      {
-         isGoal = true;
-         break;
-      }
+      TransitionIndex::NodeRange dests = nfaeIndex.destinations(source, symbol);
+      destSet.insert(destSet.end(), dests.first, dests.second);
    }
-   return isGoal;
+   sortNodeSet(destSet);
 }
 
 //------------------------------------------------------------------------------
-// fillEpsilonClosure(int& curState, unordered_set<int>& closure)
-// Conducts a depth first search for nodes reachable with EPSILON and puts them
-// into closure.
+// makeTranslation(Translator& translator, vector<char>& language)
+// Translates, breadth first, nfae to dfa.  Every node set on the queue
+// already has its dfa node assigned.
 // Calls:
-//    depthFirstSearchEpsilon() - the non-translator version.
+//    translateTransition()
 //------------------------------------------------------------------------------
-void CompiledNfaEpsilon::fillEpsilonClosure(int& curState,
-   unordered_set<int>& closure)
+void CompiledNfaEpsilon::makeTranslation(Translator& translator,
+   vector<char>& language) const
 {
-   for(Transition transition : transitions)
+   while(!translator.nodeMapQueue.empty())
    {
-      if(transition.source == curState && transition.transitionChar == EPSILON)
+      StatTimer timer;
+      for(char symbol : language)
       {
-         closure.emplace(transition.source);
-         depthFirstSearchEpsilon(transitions, transition.source, closure);
-         break;
+         translateTransition(translator, symbol);
       }
+      translationStats.recordExpansion(timer);
+      translator.nodeMapQueue.pop();
    }
 }
 
 //------------------------------------------------------------------------------
-// fillDestSetFromSrcSet(unordered_set<int>& sourceNodeSet, char& inputChar,
-// unordered_set<int>& destinationNodeSet)
-// If sourceNodeSet is not empty, adds every node reachable from sourceNodeSet
-// on inputchar to destinationNodeSet.
+// translateTransition(Translator& translator, char& symbol)
+// Declares and assigns the set of nfae nodes reachable on
+// transitionChar symbol from the node set at the front of the queue.  An
+// empty set needs no dfa transition.  Otherwise the set is looked up in
+// translator.dfaSets; a set seen for the first time, by any path, gets the
+// next dfa node, is checked for goal node status and is pushed onto
+// nodeMapQueue.  A dfa transition to the set's dfa node is then made.
+// Calls:
+//    buildDestinationSetWithTran()
+//    isGoalNode()
+//    nodeMapQueue.push()
+//    makeNewDfaTransition()
 //------------------------------------------------------------------------------
-void CompiledNfaEpsilon::fillDestSetFromSrcSet(unordered_set<int>& sourceNodeSet,
-   char& inputChar,unordered_set<int>& destinationNodeSet)
+void CompiledNfaEpsilon::translateTransition(Translator& translator,
+   char& symbol) const
 {
-   if(sourceNodeSet.size() == 0)
+   NodeSet destSet;
+   buildDestinationSetWithTran(translator, destSet, symbol);
+   if(destSet.empty())
    {
+      translationStats.recordNodeSet(0, false);
       return;
    }
 
-   for(Transition transition : transitions)
+   pair<int, bool> found = translator.dfaSets.intern(destSet);
+   int dest = found.first;
+   translationStats.recordNodeSet(destSet.size(), found.second);
+   if(found.second)
    {
-      auto src = sourceNodeSet.find(transition.source);
-      if(src != sourceNodeSet.end())
+      translator.dfa.addNode();
+      if(isGoalNode(translator.nfaeIndex, destSet))
       {
-         if(transition.transitionChar == inputChar)
-         {
-            destinationNodeSet.emplace(transition.destination);
-         }
+         translator.dfa.setGoal(dest);
       }
+      translator.nodeMapQueue.push(destSet, dest);
    }
+   makeNewDfaTransition(translator, symbol, dest);
+}
+
+//------------------------------------------------------------------------------
+// makeNewDfaTransition(Translator& translator, char& symbol, int& dest)
+// Creates a Transition from translator.nodeMapQueue.unmappedNodes.front(),
+// symbol and dest. Then we add this Transition to translator.dfa
+//------------------------------------------------------------------------------
+void CompiledNfaEpsilon::makeNewDfaTransition(Translator& translator,
+   char& symbol, int& dest) const
+{
+   translator.dfa.addTransition(
+      translator.nodeMapQueue.unmappedNodes.front(), symbol, dest);
+}
+
+//------------------------------------------------------------------------------
+// isGoalNode(const TransitionIndex& nfaeIndex, const NodeSet& destinationSet)
+// Returns true if any node destinationSet is also a goal node of nfae,
+// returns false otherwise.  In other words, returns true if the intersection
+// between these two sets is not empty, false otherwise.
+//------------------------------------------------------------------------------
+bool CompiledNfaEpsilon::isGoalNode(const TransitionIndex& nfaeIndex,
+   const NodeSet& destinationSet) const
+{
+   for(int node : destinationSet)
+   {
+      if(nfaeIndex.isGoal(node))
+      {
+         return true;
+      }
+   }
+   return false;
 }
 
 //------------------------------------------------------------------------------
@@ -395,29 +804,71 @@ void CompiledNfaEpsilon::fillDestSetFromSrcSet(unordered_set<int>& sourceNodeSet
 // destinationNodeSet.
 //------------------------------------------------------------------------------
 void CompiledNfaEpsilon::fillDestSetFromTransitions(int& curState,
-   char& inputChar,unordered_set<int>& destinationNodeSet)
+   char& inputChar,unordered_set<int>& destinationNodeSet) const
 {
-   for(auto it = transitions.begin(); it!= transitions.end(); ++it)
+   int dense = index.denseOf(curState);
+   if(dense < 0)
    {
-      if(it->source == curState && it->transitionChar == inputChar)
-      {
-         destinationNodeSet.emplace(it->destination);
-      }
+      return;
+   }
+   TransitionIndex::NodeRange dests = index.destinations(dense, inputChar);
+   for(const int* dest = dests.first; dest != dests.second; ++dest)
+   {
+      destinationNodeSet.emplace(index.nodeOf(*dest));
    }
 }
 
 //------------------------------------------------------------------------------
 // checkIfSetContainsGoalNode(unordered_set<int>& nodeSet)
-// Returns true of nodeSet contains a node that is also contained in goalNodes,
-// false otehrwise.  In other words, returns true if the intersection is not
-// empty, false otherwise.
+// Returns true of nodeSet contains a node that index marks as a goal node,
+// false otehrwise.  In other words, returns true if the intersection with
+// the goal nodes is not empty, false otherwise.
 //------------------------------------------------------------------------------
-bool CompiledNfaEpsilon::checkIfSetContainsGoalNode(unordered_set<int>& nodeSet)
+bool CompiledNfaEpsilon::checkIfSetContainsGoalNode(unordered_set<int>& nodeSet) const
 {
    for(int node : nodeSet)
    {
-      auto nodeIterator = goalNodes.find(node);
-      return (nodeIterator == goalNodes.end()) ? false : true;
+      int dense = index.denseOf(node);
+      if(dense >= 0 && index.isGoal(dense))
+      {
+         return true;
+      }
    }
    return false;
 }
+
+//------------------------------------------------------------------------------
+// epsilonFreeIndex(const FiniteStateMachine& nfae)
+// Indexes nfae, eliminates its epsilon transitions and indexes the result.
+// The first index is gone before the second is built.
+//------------------------------------------------------------------------------
+TransitionIndex CompiledNfaEpsilon::epsilonFreeIndex(
+   const FiniteStateMachine& nfae)
+{
+   CompactStateMachine epsilonFree = TransitionIndex(nfae).eliminateEpsilons();
+   return TransitionIndex(move(epsilonFree));
+}
+
+//------------------------------------------------------------------------------
+// epsilonFreeIndex(const CompactStateMachine& nfae)
+// As above, for the contiguous representation.
+//------------------------------------------------------------------------------
+TransitionIndex CompiledNfaEpsilon::epsilonFreeIndex(
+   const CompactStateMachine& nfae)
+{
+   CompactStateMachine epsilonFree = TransitionIndex(nfae).eliminateEpsilons();
+   return TransitionIndex(move(epsilonFree));
+}
+
+//------------------------------------------------------------------------------
+// epsilonFreeIndex(CompactStateMachine&& nfae)
+// As above, except that nfae itself is released by the first index, before
+// its epsilon transitions are eliminated.
+//------------------------------------------------------------------------------
+TransitionIndex CompiledNfaEpsilon::epsilonFreeIndex(
+   CompactStateMachine&& nfae)
+{
+   CompactStateMachine epsilonFree =
+      TransitionIndex(move(nfae)).eliminateEpsilons();
+   return TransitionIndex(move(epsilonFree));
+}
@@ -9,10 +9,20 @@
 #ifndef COMPILEDNFAEPSILON_H
 #define COMPILEDNFAEPSILON_H
 #include <iostream>
+#include <cstdint>
 #include <unordered_set>
+#include <unordered_map>
+#include <vector>
 #include "FiniteStateMachine.h"
+#include "CompactStateMachine.h"
+#include "TransitionIndex.h"
+#include "NodeSetTable.h"
+#include "EngineStats.h"
+#include "WorkStealingPool.h"
 #include <list>
+#include <mutex>
 #include <queue>
+#include <string_view>
 
 using namespace std;
 
@@ -22,69 +32,277 @@ using namespace std;
 // or translates a FiniteStateMachine in NFA format into a
 // FiniteStateMachine in DFA format.
 // No defaul constructor, instead can only be constructed with a
-// FiniteStateMachine - should be formatted for NFA-EPSILON but there is no
-// validation that the FiniteStateMachine is in NFA-EPSILON format.
-// Only two pbulic methods:
-//    checkString()
-//    translateToDFA()
+// FiniteStateMachine or CompactStateMachine - should be formatted for
+// NFA-EPSILON but there is no validation that it is in NFA-EPSILON format.
+// Only the TransitionIndex of the machine is kept, not the machine itself,
+// and it is the index of the machine with its epsilon transitions
+// eliminated (TransitionIndex::eliminateEpsilons()), as are the indexes of
+// the machines passed to the translators.  Closures are folded into the
+// transitions and goal nodes once, so neither matching nor translation takes
+// one.
+// Matching runs in one of two MatchModes:
+//    BIT_PARALLEL   - (default) the active node set is a bitset.  For an
+//                     NFA of at most 64 nodes and MAX_FOLLOW_CLASSES
+//                     distinct chars it is one word, and each input char
+//                     ORs one followTable entry per non-zero byte of it, at
+//                     most 8, so matching is O(n) for input length n.
+//                     Larger NFAs set the bit of every destination of the
+//                     edges each active node has on the char, so a char
+//                     costs O(m/64 + a + d) for m nodes, a of them active,
+//                     and d edges followed, and matching O(n*(m+e)) for e
+//                     transitions.
+//    NODE_SET       - the active node set is an unordered_set rebuilt from
+//                     the transition list for every input character.
+// Once constructed a CompiledNfaEpsilon is never modified: checkString() and
+// translateToDFA() are const and keep their working state on the stack or in
+// a caller-owned MatchContext, so one instance can be shared by any number
+// of threads without locking.
+// An input can also be matched a piece at a time, for instance by
+// NfaStreamMatcher: startMatch() resets a MatchContext, advanceMatch() feeds
+// it the next piece and isAccepted() reports whether everything fed so far
+// matches.  Only the active node set is kept between pieces.
+// The translators build a CompactStateMachine; the FiniteStateMachine
+// overloads convert it with toFiniteStateMachine() before returning it.
+// translateToDFAParallel() builds the same DFA as translateToDFA(), node
+// numbers and transition order included, but expands the node sets of each
+// breadth first level on the threads of a WorkStealingPool.  New node sets
+// are interned in a table split into INTERN_SHARDS separately locked
+// shards and are numbered once their level is done, in the order a serial
+// translation would have found them.
+// A build with -DFA_ENABLE_STATS counts the work done by matching in an
+// NfaStats and by translation in a TranslationStats; see EngineStats.h.
+// The counters are atomic, so a shared instance still needs no locking.
+// Public methods:
+//    checkString() x4
+//    translateToDFA() x4
+//    translateToCompactDFA()
+//    translateToDFAParallel() x4
+//    translateToCompactDFAParallel()
+//    startMatch()
+//    advanceMatch()
+//    isAccepted()
+//    matchStatistics()
+//    translationStatistics()
+//    resetStatistics()
 // Many private helper functions:
 //    isMatch()
+//    isMatchNodeSet()
+//    isMatchBitParallel()
+//    advanceNodeSet()
+//    advanceBitParallel()
+//    followWord()
+//    compileBitParallel()
+//    fillDestinationSet()
 //    buildDestinationSetWithTran()
-//    setUnion()
 //    makeNewDfaTransition()
-//    depthFirstSearchEpsilon()
-//    fillEpsilonClosure()
-//    fillDestSetFromSrcSet()
 //    fillDestSetFromTransitions()
 //    checkIfSetContainsGoalNode()
 //    makeLanguage()
 //    isGoalNode()
 //    translateTransition()
 //    makeTranslation()
-//    depthFirstSearchEpsilon()
 //    initializeTranslator()
-//    initializeDestinationSet()
+//    makeParallelTranslation()
+//    expandNodeSet()
+//    internNodeSet()
+//    numberLevel()
+//    translate()
+//    translateParallel()
+//    epsilonFreeIndex() x3
 // Members
-//    start
-//    goalNodes
-//    transitions
+//    index
+//    matchMode
+//    stateCount
+//    maskWords
+//    startMask
+//    goalMask
+//    stepOffsets
+//    stepChars
+//    stepDestOffsets
+//    stepDests
+//    charClass
+//    followTable
+//    matchStats
+//    translationStats
+// Per call of translateToDFA()
 //    translator
-//       nfae
+//       nfaeIndex
+//       dfaSets
 //       dfa
 //       nodeMapQueue
 //          unmappedNodeSets
 //          unmappedNodes
+// Per call of translateToDFAParallel()
+//    parallelTranslator
+//       nfaeIndex
+//       shards
+//       frontier
+//       frontierBase
+//       targets
+//       created
+//       dfa
 //------------------------------------------------------------------------------
 class CompiledNfaEpsilon
 {
    public:
+      //Selects the algorithm used by checkString()
+      enum MatchMode {BIT_PARALLEL, NODE_SET};
+
+//------------------------------------------------------------------------------
+// struct MatchContext
+// Caller-owned scratch space for checkString().  A context can be reused for
+// any number of calls, on any CompiledNfaEpsilon, but by one thread at a
+// time.  Reusing one saves the allocations a fresh context makes on large
+// NFAs.  Between startMatch() and isAccepted() it also holds the active node
+// set of a piecewise match.
+//------------------------------------------------------------------------------
+      struct MatchContext
+      {
+         vector<uint64_t> curStates;
+         vector<uint64_t> nextStates;
+         unordered_set<int> curNodes;
+         unordered_set<int> nextNodes;
+      };
+
       //Constructor
-      CompiledNfaEpsilon(FiniteStateMachine fsm)
-      : start(fsm.startNode), goalNodes(fsm.goalNodes),
-      transitions(fsm.transitions), fsmNFA(fsm) {}
+      CompiledNfaEpsilon(const FiniteStateMachine& fsm,
+         MatchMode mode = BIT_PARALLEL);
+
+      //Constructor from the contiguous representation
+      CompiledNfaEpsilon(const CompactStateMachine& fsm,
+         MatchMode mode = BIT_PARALLEL);
+
+      //Constructor that takes fsm over and releases it once it is indexed
+      CompiledNfaEpsilon(CompactStateMachine&& fsm,
+         MatchMode mode = BIT_PARALLEL);
 
       //Destructor - key word 'new' was not used in this class.
       ~CompiledNfaEpsilon(){}
 
    //public methods
       //Returns isMatch() bool value
-      inline bool checkString(string inputString)
-         {return isMatch(inputString, 0, start);}
+      inline bool checkString(string_view inputString) const
+         {MatchContext context;
+          return isMatch(inputString.data(), inputString.size(), context);}
+
+      //Returns isMatch() bool value for a raw byte span
+      inline bool checkString(const char* input, size_t length) const
+         {MatchContext context; return isMatch(input, length, context);}
+
+      //Returns isMatch() bool value, working in context
+      inline bool checkString(string_view inputString,
+         MatchContext& context) const
+         {return isMatch(inputString.data(), inputString.size(), context);}
+
+      //Returns isMatch() bool value for a raw byte span, working in context
+      inline bool checkString(const char* input, size_t length,
+         MatchContext& context) const
+         {return isMatch(input, length, context);}
 
       //Translates an NFAE passed as an argument
-      FiniteStateMachine translateToDFA(FiniteStateMachine nfae);
+      inline FiniteStateMachine translateToDFA(
+         const FiniteStateMachine& nfae) const
+         {return translate(epsilonFreeIndex(nfae)).toFiniteStateMachine();}
+
+      //Translates an NFAE passed as an argument
+      inline CompactStateMachine translateToDFA(
+         const CompactStateMachine& nfae) const
+         {return translate(epsilonFreeIndex(nfae));}
+
+      //Translates an NFAE passed as an argument, releasing it once indexed
+      inline CompactStateMachine translateToDFA(
+         CompactStateMachine&& nfae) const
+         {return translate(epsilonFreeIndex(move(nfae)));}
 
       //Translates the member NFAE
-      FiniteStateMachine translateToDFA(void);
+      inline FiniteStateMachine translateToDFA(void) const
+         {return translate(index).toFiniteStateMachine();}
+
+      //Translates the member NFAE
+      inline CompactStateMachine translateToCompactDFA(void) const
+         {return translate(index);}
+
+      //Translates an NFAE passed as an argument on the threads of pool
+      inline FiniteStateMachine translateToDFAParallel(
+         const FiniteStateMachine& nfae, WorkStealingPool& pool) const
+         {return translateParallel(epsilonFreeIndex(nfae), pool)
+            .toFiniteStateMachine();}
+
+      //Translates an NFAE passed as an argument on the threads of pool
+      inline CompactStateMachine translateToDFAParallel(
+         const CompactStateMachine& nfae, WorkStealingPool& pool) const
+         {return translateParallel(epsilonFreeIndex(nfae), pool);}
+
+      //Translates an NFAE passed as an argument on the threads of pool,
+      //releasing it once indexed
+      inline CompactStateMachine translateToDFAParallel(
+         CompactStateMachine&& nfae, WorkStealingPool& pool) const
+         {return translateParallel(epsilonFreeIndex(move(nfae)), pool);}
+
+      //Translates the member NFAE on the threads of pool
+      inline FiniteStateMachine translateToDFAParallel(
+         WorkStealingPool& pool) const
+         {return translateParallel(index, pool).toFiniteStateMachine();}
+
+      //Translates the member NFAE on the threads of pool
+      inline CompactStateMachine translateToCompactDFAParallel(
+         WorkStealingPool& pool) const
+         {return translateParallel(index, pool);}
+
+      //Puts context at the start of a new input
+      void startMatch(MatchContext& context) const;
+
+      //Advances context over the next piece of input, false once none match
+      bool advanceMatch(MatchContext& context, const char* input,
+         size_t length) const;
+
+      //Returns true if the input fed to context so far matches
+      bool isAccepted(MatchContext& context) const;
+
+      //Counters of the matching done so far, all zero without FA_ENABLE_STATS
+      inline const NfaStats& matchStatistics(void) const {return matchStats;}
+
+      //Counters of the translations done so far, all zero without
+      //FA_ENABLE_STATS
+      inline const TranslationStats& translationStatistics(void) const
+         {return translationStats;}
+
+      //Sets both sets of counters back to zero
+      inline void resetStatistics(void) const
+         {matchStats.reset(); translationStats.reset();}
 
    private:
       CompiledNfaEpsilon();   //No public default constructor
 
    //private members
-      int start;                       //Start Node
-      unordered_set<int> goalNodes;    //Goal Nodes
-      list<Transition> transitions;    //List of Transitions
-      FiniteStateMachine fsmNFA;       //NFAE FiniteStateMachine
+      TransitionIndex index;           //Index of the NFAE without epsilons
+      MatchMode matchMode;             //Algorithm used by isMatch()
+
+   //bit parallel simulation tables - nodes renumbered densely
+      int stateCount;                  //Number of dense nodes
+      int maskWords;                   //uint64_t words per node mask
+      vector<uint64_t> startMask;      //Start node
+      vector<uint64_t> goalMask;       //Dense goal nodes
+      //stepChars[stepOffsets[s]] .. stepChars[stepOffsets[s + 1] - 1] are
+      //the distinct chars leaving dense node s, in ascending order, and
+      //stepDests[stepDestOffsets[i]] .. stepDests[stepDestOffsets[i + 1] - 1]
+      //the nodes reached on stepChars[i]
+      vector<int> stepOffsets;
+      vector<unsigned char> stepChars;
+      vector<int> stepDestOffsets;
+      vector<int> stepDests;
+      //One word NFAs only, empty otherwise: charClass maps every char to
+      //its column (0 for chars no node reads) and followTable[(class *
+      //FOLLOW_CHUNKS + c) * 256 + v] is the union of the sets reached on
+      //that class by the nodes of byte c of the active set, if it is v
+      vector<unsigned char> charClass;
+      vector<uint64_t> followTable;
+      static constexpr int FOLLOW_CHUNKS = 8;        //Bytes per active set
+      static constexpr int MAX_FOLLOW_CLASSES = 32;  //16 KiB of table each
+
+   //statistics, updated by const matching and translating methods
+      mutable NfaStats matchStats;
+      mutable TranslationStats translationStats;
 //------------------------------------------------------------------------------
 // struct NodeMappingQueue
 // Helper struct to associate queues of sets of nodes with queues of nodes.
@@ -95,9 +313,9 @@ class CompiledNfaEpsilon
 //------------------------------------------------------------------------------
       struct NodeMappingQueue
       {
-         queue<unordered_set<int>> unmappedNodeSets;
+         queue<NodeSet> unmappedNodeSets;
          queue<int> unmappedNodes;
-         inline void push(unordered_set<int>& nodeSet, int& node)
+         inline void push(const NodeSet& nodeSet, int node)
             {unmappedNodeSets.push(nodeSet); unmappedNodes.push(node);}
          inline void pop(void)
             {unmappedNodeSets.pop(); unmappedNodes.pop();}
@@ -107,72 +325,177 @@ class CompiledNfaEpsilon
 
 //------------------------------------------------------------------------------
 // struct Translator
-// helper struct to associate a NFA-EPSILON and DFA FiniteStateMachines.
-// Contains a NodeMappingQueue nodeMapQueue and two FiniteStateMachine;
-// nfae and dfa.
+// helper struct to associate a NFA-EPSILON and the DFA built from it.
+// Contains a NodeMappingQueue nodeMapQueue, the TransitionIndex nfaeIndex of
+// the nfae being translated, the dfa being built and dfaSets, which interns
+// every NodeSet seen so far; a set's id is its dfa node.  Each call of
+// translateToDFA() uses its own Translator.
 //------------------------------------------------------------------------------
       struct Translator
       {
          NodeMappingQueue nodeMapQueue;
-         FiniteStateMachine nfae;
-         FiniteStateMachine dfa;
+         const TransitionIndex& nfaeIndex;
+         NodeSetTable dfaSets;
+         CompactStateMachine dfa;
+         explicit Translator(const TransitionIndex& nfae) : nfaeIndex(nfae) {}
       };
 
-      Translator translator;
+      static constexpr size_t INTERN_SHARDS = 64;  //Locks in the intern table
+      //Tasks per pool thread each level is split into, for load balance
+      static constexpr size_t LEVEL_TASKS_PER_WORKER = 8;
+
+//------------------------------------------------------------------------------
+// struct InternEntry
+// Value of an interned NodeSet: its dfa node, or -1 until its level is
+// numbered, the position (source index in the frontier times language size
+// plus symbol index) at which the level first reached it, and its key.
+//------------------------------------------------------------------------------
+      struct InternEntry
+      {
+         int dfaId;
+         uint64_t discovery;
+         const NodeSet* nodeSet;
+      };
+
+//------------------------------------------------------------------------------
+// struct InternShard
+// One lock and the NodeSets whose hash selects it.  Map values never move,
+// so InternEntry pointers stay valid while other threads insert.
+//------------------------------------------------------------------------------
+      struct InternShard
+      {
+         mutex lock;
+         unordered_map<NodeSet, InternEntry, NodeSetHash> ids;
+      };
+
+//------------------------------------------------------------------------------
+// struct ParallelTranslator
+// State of one translateToDFAParallel() call.  frontier holds the node sets
+// of the level being expanded; frontier[i] is dfa node frontierBase + i.
+// Expanding frontier[i] on symbol k sets targets[i * language size + k] to
+// the entry of the destination set (nullptr if empty) and adds every entry
+// it created to created[i].
+//------------------------------------------------------------------------------
+      struct ParallelTranslator
+      {
+         const TransitionIndex& nfaeIndex;
+         vector<InternShard> shards;
+         vector<const NodeSet*> frontier;
+         int frontierBase;
+         vector<InternEntry*> targets;
+         vector<vector<InternEntry*>> created;
+         CompactStateMachine dfa;
+         explicit ParallelTranslator(const TransitionIndex& nfae)
+            : nfaeIndex(nfae), shards(INTERN_SHARDS), frontierBase(0) {}
+      };
 
    //private metods
    //Extended documentation for these methods contained in CompiledNfaEpsilon.h
 
-      //Checks whether inputString matches the FiniteStateMachine
-      bool isMatch(string inputString, unsigned posInString, int curState);
+      //Checks whether input matches the FiniteStateMachine
+      inline bool isMatch(const char* input, size_t length,
+         MatchContext& context) const
+         {return (matchMode == BIT_PARALLEL) ?
+            isMatchBitParallel(input, length, context) :
+            isMatchNodeSet(input, length, context);}
 
-      //Fills destination node set with destination nodes
-      void buildDestinationSetWithTran(unordered_set<int>& destSet, char& symbol);
+      //isMatch() using unordered_set node sets
+      bool isMatchNodeSet(const char* input, size_t length,
+         MatchContext& context) const;
 
-      //Returns the union of setA and setB
-      unordered_set<int>& setUnion(unordered_set<int>& setA, unordered_set<int>& setB);
+      //isMatch() using precomputed bit masks
+      bool isMatchBitParallel(const char* input, size_t length,
+         MatchContext& context) const;
 
-      //Creates a DFA Transition and adds it to the dfa
-      void makeNewDfaTransition(char& symbol, unordered_set<int> destSet, int& dest);
+      //advanceMatch() using unordered_set node sets
+      bool advanceNodeSet(const char* input, size_t length,
+         MatchContext& context) const;
+
+      //advanceMatch() using precomputed bit masks
+      bool advanceBitParallel(const char* input, size_t length,
+         MatchContext& context) const;
 
-      //fills the epsilcon closure via a depth first search
-      void depthFirstSearchEpsilon(list<Transition>& transitions, int& curDest,
-         unordered_set<int>& closure);
+      //Next one word active set from curStates on inputChar, by followTable
+      inline uint64_t followWord(uint64_t curStates,
+         unsigned char inputChar) const
+         {const uint64_t* table = &followTable[
+             charClass[inputChar] * FOLLOW_CHUNKS * 256];
+          uint64_t nextStates = 0;
+          for(; curStates; curStates >>= 8, table += 256)
+             {nextStates |= table[curStates & 255];}
+          return nextStates;}
 
-      //Calls depthFirstSearchEpsilon
-      void fillEpsilonClosure(int& curState, unordered_set<int>& closure);
+      //Builds the bit parallel simulation tables
+      void compileBitParallel(void);
 
-      //Fills destination node set from source node set and transition char
-      void fillDestSetFromSrcSet(unordered_set<int>& sourceNodeSet, char& inputChar,
-         unordered_set<int>& destinationNodeSet);
+      //Adds the nodes reachable from curState on inputChar to destination set
+      void fillDestinationSet(char& inputChar, int& curState,
+         unordered_set<int>& destinationNodeSet) const;
+
+      //Fills destination node set with sorted destination nodes
+      void buildDestinationSetWithTran(Translator& translator,
+         NodeSet& destSet, char& symbol) const;
+
+      //Creates a DFA Transition and adds it to the dfa
+      void makeNewDfaTransition(Translator& translator, char& symbol,
+         int& dest) const;
 
       //Fills destination node set from Transition list and transition char
       void fillDestSetFromTransitions(int& curState, char& inputChar,
-         unordered_set<int>& destinationNodeSet);
+         unordered_set<int>& destinationNodeSet) const;
 
       //Returns true of nodeSet contains a goal node, false otherwise
-      bool checkIfSetContainsGoalNode(unordered_set<int>& nodeSet);
+      bool checkIfSetContainsGoalNode(unordered_set<int>& nodeSet) const;
 
-      //Fills a char set with all unique char in nfae
-      unordered_set<char> makeLanguage(FiniteStateMachine& nfae);
+      //Returns every unique char in nfae, in ascending order
+      vector<char> makeLanguage(const TransitionIndex& nfaeIndex) const;
 
       //Returns true if destinationSet contains a goal node, false otehrwise
-      bool isGoalNode(unordered_set<int>& destinationSet, FiniteStateMachine& nfae);
+      bool isGoalNode(const TransitionIndex& nfaeIndex,
+         const NodeSet& destinationSet) const;
 
       //Translates a set of nfae Transitions to one dfa Transition
-      void translateTransition(int& dest, char& symbol);
+      void translateTransition(Translator& translator, char& symbol) const;
 
       //Calls helper functions to create a dfa translation
-      void makeTranslation(unordered_set<char>& language);
-
-      //Another version of a depth first search for filling the epsilon closure
-      void depthFirstSearchEpsilon(int& node, unordered_set<int>& closure);
+      void makeTranslation(Translator& translator,
+         vector<char>& language) const;
 
       //Initializes the Translator
-      void initializeTranslator(FiniteStateMachine nfae);
+      void initializeTranslator(Translator& translator) const;
+
+      //Translates nfae level by level on the threads of pool
+      void makeParallelTranslation(ParallelTranslator& translator,
+         WorkStealingPool& pool) const;
+
+      //Finds and interns every destination set of one frontier node set
+      void expandNodeSet(ParallelTranslator& translator,
+         const vector<char>& language, size_t item) const;
+
+      //Returns the entry of nodeSet, creating it if it is new
+      InternEntry* internNodeSet(ParallelTranslator& translator,
+         NodeSet& nodeSet, uint64_t discovery, bool& isNew) const;
+
+      //Numbers the sets found by a level and adds its dfa transitions
+      void numberLevel(ParallelTranslator& translator,
+         const vector<char>& language) const;
+
+      //Translates the nfae indexed by nfaeIndex
+      CompactStateMachine translate(const TransitionIndex& nfaeIndex) const;
+
+      //Translates the nfae indexed by nfaeIndex on the threads of pool
+      CompactStateMachine translateParallel(const TransitionIndex& nfaeIndex,
+         WorkStealingPool& pool) const;
+
+      //Index of nfae with its epsilon transitions eliminated
+      static TransitionIndex epsilonFreeIndex(const FiniteStateMachine& nfae);
+
+      //Index of nfae with its epsilon transitions eliminated
+      static TransitionIndex epsilonFreeIndex(const CompactStateMachine& nfae);
 
-      //Fills the destination set
-      unordered_set<int> initializeDestinationSet(char& inputChar, int& curState);
+      //Index of nfae with its epsilon transitions eliminated, releasing nfae
+      //once it is indexed
+      static TransitionIndex epsilonFreeIndex(CompactStateMachine&& nfae);
 };
 
 #endif // COMPILEDNFAEPSILON_H
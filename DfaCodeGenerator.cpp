@@ -0,0 +1,223 @@
+//------------------------------------------------------------------------------
+// DfaCodeGenerator.cpp
+// agent
+// 17 October 2026
+// Implementation for DfaCodeGenerator.h
+// Contains implementation for:
+//    generate()
+//    writeHeader()
+//    isIdentifier()
+//    writeState()
+//------------------------------------------------------------------------------
+#include "DfaCodeGenerator.h"
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+//------------------------------------------------------------------------------
+// generate(const string& name)
+// Collects the undecided states reachable from the start state in breadth
+// first order, start state first so the function falls into it, and marks
+// every state some transition jumps to, since an unused label draws a
+// warning.  A decided start state needs no states at all.  Then
+// writes the include guard, the matcher with one block per state, and the
+// string_view overload.
+// Calls:
+//    isIdentifier()
+//    writeState()
+//------------------------------------------------------------------------------
+string DfaCodeGenerator::generate(const string& name) const
+{
+   if(!isIdentifier(name))
+   {
+      return "";
+   }
+
+   int stateCount = dfa.size();
+   vector<char> reached(stateCount, 0);
+   vector<char> labeled(stateCount, 0);
+   vector<int> order;
+   int start = dfa.startState();
+   if(!dfa.isDecidedState(start))
+   {
+      reached[start] = 1;
+      order.push_back(start);
+   }
+   for(size_t next = 0; next < order.size(); ++next)
+   {
+      for(int byte = 0; byte < 256; ++byte)
+      {
+         int dest = dfa.nextState(order[next], byte);
+         if(dfa.isDecidedState(dest))
+         {
+            continue;
+         }
+         labeled[dest] = 1;
+         if(!reached[dest])
+         {
+            reached[dest] = 1;
+            order.push_back(dest);
+         }
+      }
+   }
+
+   string guard;
+   for(char c : name)
+   {
+      guard += static_cast<char>(toupper(static_cast<unsigned char>(c)));
+   }
+   guard += "_GENERATED_H";
+
+   ostringstream out;
+   out << "//" << string(78, '-') << "\n"
+      << "// Generated by DfaCodeGenerator - do not edit.\n"
+      << "// Direct-coded matcher of a DFA with " << order.size()
+      << " live states.\n"
+      << "//" << string(78, '-') << "\n"
+      << "#ifndef " << guard << "\n"
+      << "#define " << guard << "\n"
+      << "#include <cstddef>\n"
+      << "#include <string_view>\n\n"
+      << "namespace " << name << "\n{\n"
+      << "   //Returns true if the length bytes at input match the DFA\n"
+      << "   inline bool checkString(const char* input, std::size_t length)\n"
+      << "   {\n";
+   if(order.empty())
+   {
+      out << "      (void)input;\n"
+         << "      (void)length;\n"
+         << "      return " << (dfa.isGoalState(start) ? "true" : "false")
+         << ";\n";
+   }
+   else
+   {
+      out << "      const unsigned char* pos =\n"
+         << "         reinterpret_cast<const unsigned char*>(input);\n"
+         << "      const unsigned char* const end = pos + length;\n";
+      for(int state : order)
+      {
+         writeState(out, state, labeled);
+      }
+   }
+   out << "   }\n\n"
+      << "   //Returns checkString() of the bytes of input\n"
+      << "   inline bool checkString(std::string_view input)\n"
+      << "      {return checkString(input.data(), input.size());}\n"
+      << "}\n\n"
+      << "#endif // " << guard << "\n";
+   return out.str();
+}
+
+//------------------------------------------------------------------------------
+// writeHeader(const string& path, const string& name)
+// Writes generate(name) to path, replacing any file already there.
+// Calls:
+//    generate()
+//------------------------------------------------------------------------------
+bool DfaCodeGenerator::writeHeader(const string& path,
+   const string& name) const
+{
+   string source = generate(name);
+   if(source.empty())
+   {
+      return false;
+   }
+   ofstream file(path, ios::trunc);
+   file << source;
+   file.close();
+   return !file.fail();
+}
+
+//------------------------------------------------------------------------------
+// isIdentifier(const string& name)
+// Letters, digits and underscores, not starting with a digit.  Keywords are
+// not checked for; the compiler reports those.
+//------------------------------------------------------------------------------
+bool DfaCodeGenerator::isIdentifier(const string& name)
+{
+   if(name.empty() || isdigit(static_cast<unsigned char>(name[0])))
+   {
+      return false;
+   }
+   for(char c : name)
+   {
+      if(!isalnum(static_cast<unsigned char>(c)) && c != '_')
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// writeState(ostream& out, int state, const vector<char>& labeled)
+// Groups the 256 byte values by the state they lead to and writes one case
+// list per group, in order of the group's lowest byte.  The largest group
+// becomes the default, which keeps the switch short; the dead state and
+// the accepting sink are written as return false and return true.  End of
+// input returns whether state is a goal.
+//------------------------------------------------------------------------------
+void DfaCodeGenerator::writeState(ostream& out, int state,
+   const vector<char>& labeled) const
+{
+   vector<int> groupOf(dfa.size(), -1);
+   vector<int> groupDest;
+   vector<vector<int>> groupBytes;
+   for(int byte = 0; byte < 256; ++byte)
+   {
+      int dest = dfa.nextState(state, byte);
+      if(groupOf[dest] < 0)
+      {
+         groupOf[dest] = static_cast<int>(groupDest.size());
+         groupDest.push_back(dest);
+         groupBytes.emplace_back();
+      }
+      groupBytes[groupOf[dest]].push_back(byte);
+   }
+   size_t largest = 0;
+   for(size_t group = 1; group < groupDest.size(); ++group)
+   {
+      if(groupBytes[group].size() > groupBytes[largest].size())
+      {
+         largest = group;
+      }
+   }
+
+   auto jump = [&](int dest)
+   {
+      if(dfa.isDecidedState(dest))
+      {
+         return string(dfa.isGoalState(dest) ? "return true;" :
+            "return false;");
+      }
+      return "goto s" + to_string(dest) + ";";
+   };
+
+   if(labeled[state])
+   {
+      out << "   s" << state << ":\n";
+   }
+   out << "      if(pos == end) {return "
+      << (dfa.isGoalState(state) ? "true" : "false") << ";}\n"
+      << "      switch(*pos++)\n"
+      << "      {\n";
+   for(size_t group = 0; group < groupDest.size(); ++group)
+   {
+      if(group == largest)
+      {
+         continue;
+      }
+      const vector<int>& bytes = groupBytes[group];
+      for(size_t index = 0; index < bytes.size(); ++index)
+      {
+         out << ((index % 6 == 0) ? "         " : " ") << "case 0x"
+            << hex << setw(2) << setfill('0') << bytes[index] << dec << ":"
+            << ((index % 6 == 5 || index + 1 == bytes.size()) ? "\n" : "");
+      }
+      out << "            " << jump(groupDest[group]) << "\n";
+   }
+   out << "         default:\n"
+      << "            " << jump(groupDest[largest]) << "\n"
+      << "      }\n";
+}
@@ -0,0 +1,85 @@
+//------------------------------------------------------------------------------
+// DfaCodeGenerator.h
+// agent
+// 17 October 2026
+// Writes a DFA out as direct-coded C++ source
+//------------------------------------------------------------------------------
+#ifndef DFACODEGENERATOR_H
+#define DFACODEGENERATOR_H
+#include <ostream>
+#include <string>
+#include <vector>
+#include "FiniteStateMachine.h"
+#include "CompactStateMachine.h"
+#include "CompiledDfa.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// DfaCodeGenerator Class
+// Generates a self-contained C++ header that matches the same language as a
+// CompiledDfa without any tables: every state becomes a label followed by a
+// switch on the next byte, and each case is a goto to the next state's label.
+// Compilers lower a switch over many byte values to a jump table, so every
+// byte costs one computed jump that the branch predictor learns per state,
+// and states with few distinct transitions turn into plain compare chains.
+// No defaul constructor, instead can only be constructed with a
+// FiniteStateMachine or CompactStateMachine in DFA format, e.g. the output of
+// CompiledNfaEpsilon::translateToDFA(), or with a CompiledDfa, e.g. one
+// returned by CompiledDfa::load().  Machines are compiled to a CompiledDfa
+// first and the code is written from its tables, so the generated matcher
+// gives exactly the results of CompiledDfa::checkString(), first transition
+// winning on a duplicated symbol included.
+// The header defines, in namespace name:
+//    bool checkString(const char* input, size_t length)
+//    bool checkString(std::string_view input)
+// Only undecided states reachable from the start state are written;
+// transitions to the dead state return false at once, and transitions to
+// the accepting sink return true.
+// Public methods:
+//    generate()
+//    writeHeader()
+//    isIdentifier()
+// Private methods:
+//    writeState()
+// Members:
+//    dfa
+//------------------------------------------------------------------------------
+class DfaCodeGenerator
+{
+   public:
+      //Constructor
+      DfaCodeGenerator(const FiniteStateMachine& finStMch,
+         bool minimize = false) : dfa(finStMch, minimize) {}
+
+      //Constructor from the contiguous representation
+      DfaCodeGenerator(const CompactStateMachine& finStMch,
+         bool minimize = false) : dfa(finStMch, minimize) {}
+
+      //Constructor from an existing CompiledDfa, whose tables are shared
+      explicit DfaCodeGenerator(const CompiledDfa& compiled) : dfa(compiled) {}
+
+      //Destructor - key word 'new' is not used.
+      ~DfaCodeGenerator(){}
+
+      //Source of a header defining the matcher in namespace name, or "" if
+      //name is not a valid identifier
+      string generate(const string& name) const;
+
+      //Writes generate(name) to path, false if name is not a valid
+      //identifier or the file could not be written
+      bool writeHeader(const string& path, const string& name) const;
+
+      //Returns true if name can be used as a C++ identifier
+      static bool isIdentifier(const string& name);
+
+   private:
+      CompiledDfa dfa;     //Tables the code is written from
+
+      //Writes the label and switch of state; labeled marks the states some
+      //goto jumps to
+      void writeState(ostream& out, int state,
+         const vector<char>& labeled) const;
+};
+
+#endif // DFACODEGENERATOR_H
@@ -0,0 +1,93 @@
+//------------------------------------------------------------------------------
+// DfaGen.cpp
+// agent
+// 17 October 2026
+// Code generator driver for FiniteAutomata project.
+// Turns a DFA saved with CompiledDfa::save() into a direct-coded C++ header
+// with DfaCodeGenerator, for rules that are fixed at build time:
+//    dfagen input.cdfa name [output.h]   - writes the header for namespace
+//                                          name, to standard out if no
+//                                          output is given
+//    dfagen --example output.cdfa        - saves the DFA translated by
+//                                          translateToDFA() from the
+//                                          NFA-EPSILON of main.cpp,
+//                                          ab*|b*c|a*c*, to try the above on
+// MatcherCheck.cpp then compiles a generated header and checks it against
+// CompiledDfa::checkString().
+//------------------------------------------------------------------------------
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include "CompiledDfa.h"
+#include "CompiledNfaEpsilon.h"
+#include "DfaCodeGenerator.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// exampleDfa()
+// The NFA-EPSILON for ab*|b*c|a*c* from main.cpp, translated to a DFA.
+//------------------------------------------------------------------------------
+static CompiledDfa exampleDfa()
+{
+   FiniteStateMachine nfaeRegEx;
+   nfaeRegEx.nodes = {0, 1, 2, 3, 4, 5, 6};
+   nfaeRegEx.startNode = 0;
+   nfaeRegEx.goalNodes = {1, 2, 4, 5, 6};
+   nfaeRegEx.transitions.emplace_back(0, EPSILON, 1);
+   nfaeRegEx.transitions.emplace_back(0, EPSILON, 3);
+   nfaeRegEx.transitions.emplace_back(0, EPSILON, 5);
+   nfaeRegEx.transitions.emplace_back(1, 'a', 2);
+   nfaeRegEx.transitions.emplace_back(2, 'b', 2);
+   nfaeRegEx.transitions.emplace_back(3, 'b', 3);
+   nfaeRegEx.transitions.emplace_back(3, 'c', 4);
+   nfaeRegEx.transitions.emplace_back(5, 'a', 5);
+   nfaeRegEx.transitions.emplace_back(5, 'c', 6);
+   nfaeRegEx.transitions.emplace_back(6, 'c', 6);
+
+   CompiledNfaEpsilon nfae(nfaeRegEx);
+   return CompiledDfa(nfae.translateToDFA(nfaeRegEx));
+}
+
+int main(int argc, char* argv[])
+{
+   if(argc == 3 && strcmp(argv[1], "--example") == 0)
+   {
+      if(!exampleDfa().save(argv[2]))
+      {
+         fprintf(stderr, "%s: cannot write %s\n", argv[0], argv[2]);
+         return 1;
+      }
+      return 0;
+   }
+   if(argc != 3 && argc != 4)
+   {
+      fprintf(stderr, "usage: %s input.cdfa name [output.h]\n"
+         "       %s --example output.cdfa\n", argv[0], argv[0]);
+      return 1;
+   }
+
+   unique_ptr<CompiledDfa> dfa = CompiledDfa::load(argv[1]);
+   if(!dfa)
+   {
+      fprintf(stderr, "%s: %s is not a valid DFA file\n", argv[0], argv[1]);
+      return 1;
+   }
+   if(!DfaCodeGenerator::isIdentifier(argv[2]))
+   {
+      fprintf(stderr, "%s: %s is not a valid identifier\n", argv[0], argv[2]);
+      return 1;
+   }
+   DfaCodeGenerator generator(*dfa);
+   if(argc == 3)
+   {
+      cout << generator.generate(argv[2]);
+      return cout.good() ? 0 : 1;
+   }
+   if(!generator.writeHeader(argv[3], argv[2]))
+   {
+      fprintf(stderr, "%s: cannot write %s\n", argv[0], argv[3]);
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,330 @@
+//------------------------------------------------------------------------------
+// DfaMinimizer.cpp
+// agent
+// 17 October 2026
+// Implementation for DfaMinimizer.h
+// Contains implementation for:
+//    Constructor x2
+//    minimizeCompact()
+//    buildTransitionTable()
+//    refinePartition()
+//    splitBlocks()
+//    buildMinimalDfa()
+//------------------------------------------------------------------------------
+#include "DfaMinimizer.h"
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+// Constructs a DfaMinimizer for a FiniteStateMachine formatted for DFA.
+// Only the transition index is built here; the work is done by minimize().
+//------------------------------------------------------------------------------
+DfaMinimizer::DfaMinimizer(const FiniteStateMachine& dfa)
+: index(dfa), deadNode(0), nodeCount(0)
+{
+}
+
+//------------------------------------------------------------------------------
+// Constructs a DfaMinimizer for a CompactStateMachine formatted for DFA.
+//------------------------------------------------------------------------------
+DfaMinimizer::DfaMinimizer(const CompactStateMachine& dfa)
+: index(dfa), deadNode(0), nodeCount(0)
+{
+}
+
+//------------------------------------------------------------------------------
+// minimizeCompact()
+// Returns the minimal DFA equivalent to the one passed to the constructor.
+// Calls:
+//    buildTransitionTable()
+//    refinePartition()
+//    buildMinimalDfa()
+//------------------------------------------------------------------------------
+CompactStateMachine DfaMinimizer::minimizeCompact(void)
+{
+   buildTransitionTable();
+   refinePartition();
+   return buildMinimalDfa();
+}
+
+//------------------------------------------------------------------------------
+// buildTransitionTable()
+// Collects the language, numbers the nodes reachable from the start node
+// breadth first (the start node becomes 0), then fills the complete
+// transition table delta with deadNode standing in for missing transitions
+// and, by counting sort, the inverse transitions used as splitters.  Of
+// duplicate transitions the first given wins, as in CompiledDfa::build(),
+// since TransitionIndex keeps them in their original order.
+//------------------------------------------------------------------------------
+void DfaMinimizer::buildTransitionTable(void)
+{
+   int symbolOf[256];
+   fill(symbolOf, symbolOf + 256, -1);
+   for(int node = 0; node < index.size(); ++node)
+   {
+      for(int edge = index.edgesBegin(node); edge < index.edgesEnd(node); ++edge)
+      {
+         symbolOf[static_cast<unsigned char>(index.edgeSymbol(edge))] = 0;
+      }
+   }
+   for(int byte = 0; byte < 256; ++byte)
+   {
+      if(symbolOf[byte] == 0)
+      {
+         symbolOf[byte] = static_cast<int>(language.size());
+         language.push_back(static_cast<char>(byte));
+      }
+   }
+   int k = static_cast<int>(language.size());
+
+   vector<int> newId(index.size(), -1);
+   newId[index.startNode()] = 0;
+   reachable.assign(1, index.startNode());
+   for(size_t next = 0; next < reachable.size(); ++next)
+   {
+      int node = reachable[next];
+      for(int edge = index.edgesBegin(node); edge < index.edgesEnd(node); ++edge)
+      {
+         int dest = index.edgeDestination(edge);
+         if(newId[dest] < 0)
+         {
+            newId[dest] = static_cast<int>(reachable.size());
+            reachable.push_back(dest);
+         }
+      }
+   }
+   deadNode = static_cast<int>(reachable.size());
+   nodeCount = deadNode + 1;
+
+   delta.assign(nodeCount * k, deadNode);
+   for(int node = 0; node < deadNode; ++node)
+   {
+      int dense = reachable[node];
+      for(int edge = index.edgesBegin(dense); edge < index.edgesEnd(dense);
+         ++edge)
+      {
+         int symbol = symbolOf[static_cast<unsigned char>(index.edgeSymbol(edge))];
+         if(delta[node * k + symbol] == deadNode)
+         {
+            delta[node * k + symbol] = newId[index.edgeDestination(edge)];
+         }
+      }
+   }
+
+   inverseOffsets.assign(nodeCount * k + 1, 0);
+   for(int cell = 0; cell < nodeCount * k; ++cell)
+   {
+      ++inverseOffsets[delta[cell] * k + cell % k + 1];
+   }
+   for(int cell = 0; cell < nodeCount * k; ++cell)
+   {
+      inverseOffsets[cell + 1] += inverseOffsets[cell];
+   }
+   inverseSources.resize(nodeCount * k);
+   vector<int> fillPos(inverseOffsets.begin(), inverseOffsets.end() - 1);
+   for(int cell = 0; cell < nodeCount * k; ++cell)
+   {
+      inverseSources[fillPos[delta[cell] * k + cell % k]++] = cell / k;
+   }
+}
+
+//------------------------------------------------------------------------------
+// refinePartition()
+// Hopcroft's algorithm.  Starts from the goal / non-goal partition with the
+// smaller block queued as a splitter for every character.  Each splitter
+// (B, c) marks every node moving into B on c; blocks that are only partly
+// marked are split and the worklist is updated so that only the smaller half
+// is queued when the block was not already waiting.
+// Calls:
+//    splitBlocks()
+//------------------------------------------------------------------------------
+void DfaMinimizer::refinePartition(void)
+{
+   int k = static_cast<int>(language.size());
+   Partition& p = partition;
+   p.elements.clear();
+   for(int node = 0; node < deadNode; ++node)
+   {
+      if(index.isGoal(reachable[node]))
+      {
+         p.elements.push_back(node);
+      }
+   }
+   int goalCount = static_cast<int>(p.elements.size());
+   for(int node = 0; node < deadNode; ++node)
+   {
+      if(!index.isGoal(reachable[node]))
+      {
+         p.elements.push_back(node);
+      }
+   }
+   p.elements.push_back(deadNode);
+
+   p.location.resize(nodeCount);
+   p.blockOf.resize(nodeCount);
+   for(int pos = 0; pos < nodeCount; ++pos)
+   {
+      p.location[p.elements[pos]] = pos;
+      p.blockOf[p.elements[pos]] = (pos < goalCount) ? 0 : 1;
+   }
+   p.blockFirst = {0, goalCount};
+   p.blockEnd = {goalCount, nodeCount};
+   p.blockMarked = p.blockFirst;
+   if(goalCount == 0)
+   {
+      p.blockFirst = {0};
+      p.blockEnd = {nodeCount};
+      p.blockMarked = {0};
+      for(int& block : p.blockOf)
+      {
+         block = 0;
+      }
+      return;
+   }
+
+   vector<pair<int, int>> worklist;
+   vector<char> inWorklist(2 * k, 0);
+   int smaller = (goalCount <= nodeCount - goalCount) ? 0 : 1;
+   for(int symbol = 0; symbol < k; ++symbol)
+   {
+      worklist.emplace_back(smaller, symbol);
+      inWorklist[smaller * k + symbol] = 1;
+   }
+
+   vector<int> splitter;
+   vector<int> touched;
+   while(!worklist.empty())
+   {
+      int block = worklist.back().first;
+      int symbol = worklist.back().second;
+      worklist.pop_back();
+      inWorklist[block * k + symbol] = 0;
+
+      splitter.assign(p.elements.begin() + p.blockFirst[block],
+         p.elements.begin() + p.blockEnd[block]);
+      for(int target : splitter)
+      {
+         int cell = target * k + symbol;
+         for(int i = inverseOffsets[cell]; i < inverseOffsets[cell + 1]; ++i)
+         {
+            int source = inverseSources[i];
+            int sourceBlock = p.blockOf[source];
+            int pos = p.location[source];
+            int marked = p.blockMarked[sourceBlock];
+            if(pos < marked)
+            {
+               continue;
+            }
+            if(marked == p.blockFirst[sourceBlock])
+            {
+               touched.push_back(sourceBlock);
+            }
+            int other = p.elements[marked];
+            swap(p.elements[pos], p.elements[marked]);
+            p.location[other] = pos;
+            p.location[source] = marked;
+            ++p.blockMarked[sourceBlock];
+         }
+      }
+      splitBlocks(touched, worklist, inWorklist);
+   }
+}
+
+//------------------------------------------------------------------------------
+// splitBlocks(vector<int>& touched, vector<pair<int, int>>& worklist,
+// vector<char>& inWorklist)
+// Every block in touched whose nodes are only partly marked loses its marked
+// nodes to a new block.  For each character the new block is queued if the
+// old one was already queued, otherwise the smaller of the two is queued.
+// Clears the marks and touched.
+//------------------------------------------------------------------------------
+void DfaMinimizer::splitBlocks(vector<int>& touched,
+   vector<pair<int, int>>& worklist, vector<char>& inWorklist)
+{
+   int k = static_cast<int>(language.size());
+   Partition& p = partition;
+   for(int block : touched)
+   {
+      int first = p.blockFirst[block];
+      int marked = p.blockMarked[block];
+      p.blockMarked[block] = first;
+      if(marked == p.blockEnd[block])
+      {
+         continue;
+      }
+
+      int newBlock = static_cast<int>(p.blockFirst.size());
+      p.blockFirst.push_back(first);
+      p.blockEnd.push_back(marked);
+      p.blockMarked.push_back(first);
+      p.blockFirst[block] = marked;
+      p.blockMarked[block] = marked;
+      for(int pos = first; pos < marked; ++pos)
+      {
+         p.blockOf[p.elements[pos]] = newBlock;
+      }
+      inWorklist.resize(inWorklist.size() + k, 0);
+
+      bool newIsSmaller = (marked - first) <= (p.blockEnd[block] - marked);
+      for(int symbol = 0; symbol < k; ++symbol)
+      {
+         int queued = (inWorklist[block * k + symbol] || newIsSmaller) ?
+            newBlock : block;
+         if(!inWorklist[queued * k + symbol])
+         {
+            worklist.emplace_back(queued, symbol);
+            inWorklist[queued * k + symbol] = 1;
+         }
+      }
+   }
+   touched.clear();
+}
+
+//------------------------------------------------------------------------------
+// buildMinimalDfa()
+// Numbers the blocks breadth first from the block of the start node and
+// emits one node per block, skipping the block holding deadNode, along with
+// the transitions of one representative node per block.
+//------------------------------------------------------------------------------
+CompactStateMachine DfaMinimizer::buildMinimalDfa(void)
+{
+   int k = static_cast<int>(language.size());
+   Partition& p = partition;
+   int deadBlock = p.blockOf[deadNode];
+
+   CompactStateMachine minimal;
+   minimal.setStartNode(minimal.addNode());
+   if(p.blockOf[0] == deadBlock)
+   {
+      return minimal;
+   }
+
+   vector<int> blockId(p.blockFirst.size(), -1);
+   vector<int> order(1, p.blockOf[0]);
+   blockId[p.blockOf[0]] = 0;
+   for(size_t next = 0; next < order.size(); ++next)
+   {
+      int block = order[next];
+      int representative = p.elements[p.blockFirst[block]];
+      if(index.isGoal(reachable[representative]))
+      {
+         minimal.setGoal(blockId[block]);
+      }
+      for(int symbol = 0; symbol < k; ++symbol)
+      {
+         int destBlock = p.blockOf[delta[representative * k + symbol]];
+         if(destBlock == deadBlock)
+         {
+            continue;
+         }
+         if(blockId[destBlock] < 0)
+         {
+            blockId[destBlock] = static_cast<int>(order.size());
+            minimal.addNode();
+            order.push_back(destBlock);
+         }
+         minimal.addTransition(blockId[block], language[symbol],
+            blockId[destBlock]);
+      }
+   }
+   return minimal;
+}
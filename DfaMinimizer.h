@@ -0,0 +1,114 @@
+//------------------------------------------------------------------------------
+// DfaMinimizer.h
+// agent
+// 17 October 2026
+// Reduces a FiniteStateMachine in DFA format to the equivalent DFA with the
+// fewest nodes.
+//------------------------------------------------------------------------------
+#ifndef DFAMINIMIZER_H
+#define DFAMINIMIZER_H
+#include <vector>
+#include "FiniteStateMachine.h"
+#include "CompactStateMachine.h"
+#include "TransitionIndex.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// DfaMinimizer Class
+// Minimizes a FiniteStateMachine in DFA format with Hopcroft's partition
+// refinement, O(n * k * log n) for n nodes and k distinct characters.
+// Nodes unreachable from the start node are dropped first and missing
+// transitions are treated as leading to a dead node, which is removed again
+// from the result, so the minimal DFA keeps the missing-transition style of
+// the input.  Nodes of the result are numbered 0 .. n - 1 breadth first from
+// the start node, which is node 0.
+// The input may be a FiniteStateMachine or a CompactStateMachine, and the
+// result is returned as either.
+// There is no validation that the input is in DFA format.
+// Public methods:
+//    minimize()
+//    minimizeCompact()
+// Private methods:
+//    buildTransitionTable()
+//    refinePartition()
+//    splitBlocks()
+//    buildMinimalDfa()
+// Members:
+//    index
+//    language
+//    deadNode
+//    nodeCount
+//    reachable
+//    delta
+//    inverseOffsets
+//    inverseSources
+//    partition
+//------------------------------------------------------------------------------
+class DfaMinimizer
+{
+   public:
+      //Constructor
+      DfaMinimizer(const FiniteStateMachine& dfa);
+
+      //Constructor from the contiguous representation
+      DfaMinimizer(const CompactStateMachine& dfa);
+
+      //Destructor - key word 'new' is not used.
+      ~DfaMinimizer(){}
+
+      //Returns the minimal DFA equivalent to the one passed to the constructor
+      inline FiniteStateMachine minimize(void)
+         {return minimizeCompact().toFiniteStateMachine();}
+
+      //Returns minimize() as a CompactStateMachine
+      CompactStateMachine minimizeCompact(void);
+
+   private:
+      DfaMinimizer(); //no default constructor
+
+//------------------------------------------------------------------------------
+// struct Partition
+// Refinable partition of the nodes 0 .. nodeCount - 1.  The nodes of block b
+// are elements[blockFirst[b] .. blockEnd[b] - 1]; those before blockMarked[b]
+// have been marked by the current splitter.  location[n] is the position of
+// node n in elements.
+//------------------------------------------------------------------------------
+      struct Partition
+      {
+         vector<int> elements;
+         vector<int> location;
+         vector<int> blockOf;
+         vector<int> blockFirst;
+         vector<int> blockEnd;
+         vector<int> blockMarked;
+      };
+
+      TransitionIndex index;        //Adjacency index of the input DFA
+      vector<char> language;        //Distinct characters, ascending
+      int deadNode;                 //Node standing in for missing transitions
+      int nodeCount;                //Reachable nodes plus deadNode
+      vector<int> reachable;        //Dense index node of each node < deadNode
+      //Complete transition table, nodeCount x language.size()
+      vector<int> delta;
+      //inverseSources[inverseOffsets[t * k + c] .. inverseOffsets[t * k + c
+      //+ 1] - 1] are the nodes moving to t on language[c]
+      vector<int> inverseOffsets;
+      vector<int> inverseSources;
+      Partition partition;
+
+      //Fills reachable, delta and the inverse transitions
+      void buildTransitionTable(void);
+
+      //Runs Hopcroft's algorithm on partition
+      void refinePartition(void);
+
+      //Splits every block in touched by the marks of the current splitter
+      void splitBlocks(vector<int>& touched, vector<pair<int, int>>& worklist,
+         vector<char>& inWorklist);
+
+      //Builds the result from partition
+      CompactStateMachine buildMinimalDfa(void);
+};
+
+#endif // DFAMINIMIZER_H
@@ -0,0 +1,666 @@
+//------------------------------------------------------------------------------
+// EngineCheck.cpp
+// agent
+// 17 October 2026
+// Differential check driver for the matching engines.
+//    enginecheck [--seed=N] [--machines=N]
+// Random machines in NFA-EPSILON format, and random inputs for each, are
+// matched by every engine and compared with the reference: a plain
+// simulation of the FiniteStateMachine, taking epsilon closures straight
+// from its transition list.  The machines include the empty
+// CompactStateMachine and the inputs include the empty input.  Checked are:
+//    CompiledNfaEpsilon  - both MatchModes, built from either representation
+//    CompiledDfa         - from the serial and the parallel translation,
+//                          minimized or not, through checkString(), every
+//                          InterleaveMode of checkStrings(), a save() and
+//                          load() round trip, and checkStringParallel() on
+//                          long inputs, whose chunks are run speculatively;
+//                          also on machines read as DFAs with duplicate
+//                          transitions, of which the first must win
+//    JitDfa              - checkString(), find() and findAll()
+//    StreamMatcher       - both matchers, fed in random pieces
+//    LazyDfa             - the default budget and budgets so small that it
+//                          flushes in the middle of matches
+//    PatternSet          - the machine and a second one as two rules
+//    Searcher            - find(), findAll() and a Cursor, against
+//                          leftmost-longest matches found by the reference
+// Any disagreement is printed and the exit status is 1.
+//------------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "CompiledDfa.h"
+#include "CompiledNfaEpsilon.h"
+#include "JitDfa.h"
+#include "LazyDfa.h"
+#include "PatternSet.h"
+#include "Searcher.h"
+#include "StreamMatcher.h"
+#include "WorkStealingPool.h"
+
+using namespace std;
+
+//Random inputs matched per machine
+static const int INPUTS_PER_MACHINE = 40;
+//Longest random input
+static const int MAX_INPUT_LENGTH = 24;
+//Largest random machine
+static const int MAX_NODES = 10;
+//Cache budgets of a few DFA nodes, so LazyDfa flushes in the middle of
+//matches and has room left to cache nodes after them
+static const size_t SMALL_BUDGETS[] = {2500, 6600, 12000};
+//Inputs per machine also searched, whose reference matches cost O(n^2)
+static const int SEARCH_INPUTS = 10;
+//Every this many machines checkStringParallel() is run on long inputs
+static const int PARALLEL_EVERY = 250;
+//Length of those inputs, enough for several MIN_PARALLEL_CHUNKs
+static const size_t PARALLEL_LENGTH = size_t(5) << 20;
+//Mismatches printed before giving up
+static const int MAX_REPORTED = 10;
+
+//------------------------------------------------------------------------------
+// Reference Class
+// The meaning of a FiniteStateMachine, computed as directly as possible: a
+// set of active nodes, closed under EPSILON transitions after every step.
+// Slow, but shares no code with the engines it checks.
+//------------------------------------------------------------------------------
+class Reference
+{
+   public:
+      explicit Reference(const FiniteStateMachine& finStMch) : fsm(finStMch)
+         {}
+
+      //Returns true if input is in the language of fsm
+      bool matches(const string& input) const
+         {return longestMatch(input, 0, true) == input.size();}
+
+      //Returns the end of the longest match starting at begin, or npos.
+      //With whole only a match of all the rest of input counts.
+      size_t longestMatch(const string& input, size_t begin,
+         bool whole = false) const
+         {set<int> active = closure(set<int>{fsm.startNode});
+          size_t longestEnd = (!whole && isGoal(active)) ? begin :
+             string::npos;
+          for(size_t pos = begin; pos < input.size() && !active.empty();
+             ++pos)
+          {
+             set<int> next;
+             for(const Transition& transition : fsm.transitions)
+             {
+                if(!transition.isEpsilon &&
+                   transition.transitionChar == input[pos] &&
+                   active.count(transition.source))
+                {
+                   next.insert(transition.destination);
+                }
+             }
+             active = closure(next);
+             if(!whole && isGoal(active))
+             {
+                longestEnd = pos + 1;
+             }
+          }
+          return (whole && isGoal(active)) ? input.size() : longestEnd;}
+
+   private:
+      const FiniteStateMachine& fsm;
+
+      //Returns true if any of nodes is a goal node
+      bool isGoal(const set<int>& nodes) const
+         {for(int node : nodes)
+          {
+             if(fsm.goalNodes.count(node))
+             {
+                return true;
+             }
+          }
+          return false;}
+
+      //Adds every node reachable by EPSILON transitions to nodes
+      set<int> closure(set<int> nodes) const
+         {bool grew = true;
+          while(grew)
+          {
+             grew = false;
+             for(const Transition& transition : fsm.transitions)
+             {
+                if(transition.isEpsilon && nodes.count(transition.source) &&
+                   nodes.insert(transition.destination).second)
+                {
+                   grew = true;
+                }
+             }
+          }
+          return nodes;}
+};
+
+//------------------------------------------------------------------------------
+// Checker Class
+// Counts comparisons and reports the first MAX_REPORTED mismatches.
+//------------------------------------------------------------------------------
+class Checker
+{
+   public:
+      Checker() : checked(0), mismatches(0) {}
+
+      //Records one comparison of engine against the reference on input
+      void expect(const char* engine, int machine, const string& input,
+         bool expected, bool actual)
+         {++checked;
+          if(expected == actual)
+          {
+             return;
+          }
+          if(++mismatches <= MAX_REPORTED)
+          {
+             fprintf(stderr, "%s, machine %d: expected %d on \"", engine,
+                machine, expected);
+             for(unsigned char byte : input)
+             {
+                fprintf(stderr, (byte >= 32 && byte < 127) ? "%c" : "\\x%02x",
+                   byte);
+             }
+             fprintf(stderr, "\"\n");
+          }}
+
+      long checked;
+      long mismatches;
+};
+
+//------------------------------------------------------------------------------
+// randomMachine(mt19937& random)
+// A machine of 1 .. MAX_NODES nodes over the alphabet {NUL, a, b}, with
+// random edges, some of them EPSILON, and random goal nodes.  Node ids are
+// spread out so engines that renumber nodes have to.  One machine in four
+// is first given a ring of 'a' transitions through every node, so that
+// matching keeps coming back to the start node set.
+//------------------------------------------------------------------------------
+static FiniteStateMachine randomMachine(mt19937& random)
+{
+   static const char alphabet[] = {'\0', 'a', 'b'};
+   FiniteStateMachine fsm;
+   int nodeCount = 1 + random() % MAX_NODES;
+   for(int node = 0; node < nodeCount; ++node)
+   {
+      fsm.nodes.insert(node * 7);
+      if(random() % 3 == 0)
+      {
+         fsm.goalNodes.insert(node * 7);
+      }
+   }
+   fsm.startNode = (random() % nodeCount) * 7;
+   if(random() % 4 == 0)
+   {
+      for(int node = 0; node < nodeCount; ++node)
+      {
+         fsm.transitions.emplace_back(node * 7, 'a',
+            (node + 1) % nodeCount * 7);
+      }
+   }
+   int edgeCount = random() % (3 * nodeCount + 1);
+   for(int edge = 0; edge < edgeCount; ++edge)
+   {
+      int source = (random() % nodeCount) * 7;
+      int destination = (random() % nodeCount) * 7;
+      if(random() % 4 == 0)
+      {
+         fsm.transitions.emplace_back(source, EPSILON, destination);
+      }
+      else
+      {
+         fsm.transitions.emplace_back(source, alphabet[random() % 3],
+            destination);
+      }
+   }
+   return fsm;
+}
+
+//------------------------------------------------------------------------------
+// randomInputs(mt19937& random)
+// The empty input, then random strings over {NUL, a, b, c}; c is on no
+// edge, so it checks the dead state.
+//------------------------------------------------------------------------------
+static vector<string> randomInputs(mt19937& random)
+{
+   static const char alphabet[] = {'\0', 'a', 'b', 'a', 'b', 'c'};
+   vector<string> inputs(1);
+   for(int count = 1; count < INPUTS_PER_MACHINE; ++count)
+   {
+      string input(random() % (MAX_INPUT_LENGTH + 1), 'a');
+      for(char& inputChar : input)
+      {
+         inputChar = alphabet[random() % 6];
+      }
+      inputs.push_back(input);
+   }
+   return inputs;
+}
+
+//------------------------------------------------------------------------------
+// feedPieces(Matcher& stream, const string& input, mt19937& random)
+// Feeds input to a stream matcher in random pieces, empty ones included,
+// stopping early once feed() says the result is decided.
+//------------------------------------------------------------------------------
+template<class Matcher>
+static bool feedPieces(Matcher& stream, const string& input, mt19937& random)
+{
+   size_t pos = 0;
+   bool undecided = true;
+   while(undecided && pos < input.size())
+   {
+      size_t length = random() % (input.size() - pos + 1);
+      undecided = stream.feed(input.data() + pos, length);
+      pos += length;
+   }
+   return stream.finish();
+}
+
+//------------------------------------------------------------------------------
+// sameMatches(const vector<Searcher::Match>& found,
+// const vector<Searcher::Match>& expected)
+// Returns true if both lists hold the same matches in the same order.
+//------------------------------------------------------------------------------
+static bool sameMatches(const vector<Searcher::Match>& found,
+   const vector<Searcher::Match>& expected)
+{
+   if(found.size() != expected.size())
+   {
+      return false;
+   }
+   for(size_t i = 0; i < found.size(); ++i)
+   {
+      if(found[i].start != expected[i].start ||
+         found[i].end != expected[i].end)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// checkLazyDfa(Checker& checker, int machine, const FiniteStateMachine& fsm,
+// const vector<string>& inputs, const vector<bool>& expected)
+// One LazyDfa with the default budget and one per SMALL_BUDGETS, which
+// flush their caches during matches and keep matching after them.  Each is
+// fed every input twice, so later inputs run on a cache left by earlier
+// ones.
+//------------------------------------------------------------------------------
+static void checkLazyDfa(Checker& checker, int machine,
+   const FiniteStateMachine& fsm, const vector<string>& inputs,
+   const vector<bool>& expected)
+{
+   vector<LazyDfa> engines(1, LazyDfa(fsm));
+   for(size_t budget : SMALL_BUDGETS)
+   {
+      engines.emplace_back(fsm, budget);
+   }
+   for(LazyDfa& lazy : engines)
+   {
+      for(int round = 0; round < 2; ++round)
+      {
+         for(size_t i = 0; i < inputs.size(); ++i)
+         {
+            checker.expect("LazyDfa", machine, inputs[i], expected[i],
+               lazy.checkString(inputs[i]));
+         }
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// checkNfa(Checker& checker, int machine, const FiniteStateMachine& fsm,
+// const CompactStateMachine& compact, const vector<string>& inputs,
+// const vector<bool>& expected, mt19937& random)
+// Both MatchModes, built from either representation.  Each is also matched
+// through one reused MatchContext and through an NfaStreamMatcher fed the
+// input in random pieces.
+//------------------------------------------------------------------------------
+static void checkNfa(Checker& checker, int machine,
+   const FiniteStateMachine& fsm, const CompactStateMachine& compact,
+   const vector<string>& inputs, const vector<bool>& expected,
+   mt19937& random)
+{
+   vector<CompiledNfaEpsilon> engines;
+   engines.emplace_back(fsm, CompiledNfaEpsilon::BIT_PARALLEL);
+   engines.emplace_back(compact, CompiledNfaEpsilon::BIT_PARALLEL);
+   engines.emplace_back(fsm, CompiledNfaEpsilon::NODE_SET);
+   engines.emplace_back(compact, CompiledNfaEpsilon::NODE_SET);
+   for(const CompiledNfaEpsilon& nfae : engines)
+   {
+      CompiledNfaEpsilon::MatchContext context;
+      NfaStreamMatcher stream(nfae);
+      for(size_t i = 0; i < inputs.size(); ++i)
+      {
+         checker.expect("CompiledNfaEpsilon", machine, inputs[i],
+            expected[i], nfae.checkString(inputs[i]));
+         checker.expect("CompiledNfaEpsilon context", machine, inputs[i],
+            expected[i], nfae.checkString(inputs[i], context));
+         checker.expect("NfaStreamMatcher", machine, inputs[i], expected[i],
+            feedPieces(stream, inputs[i], random));
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// checkDfa(Checker& checker, int machine, const CompactStateMachine& compact,
+// const vector<string>& inputs, const vector<bool>& expected,
+// WorkStealingPool& pool, mt19937& random)
+// CompiledDfas of the serial and the parallel translation, minimized or
+// not, and the same DFAs loaded back from a file with and without
+// verification.  Each is matched input by input, in batches through every
+// InterleaveMode, through a DfaStreamMatcher and as a JitDfa.
+//------------------------------------------------------------------------------
+static void checkDfa(Checker& checker, int machine,
+   const CompactStateMachine& compact, const vector<string>& inputs,
+   const vector<bool>& expected, WorkStealingPool& pool, mt19937& random)
+{
+   static const CompiledDfa::InterleaveMode modes[] = {
+      CompiledDfa::INTERLEAVE_AUTO, CompiledDfa::INTERLEAVE_SCALAR,
+      CompiledDfa::INTERLEAVE_AVX2, CompiledDfa::INTERLEAVE_AVX512};
+   CompiledNfaEpsilon nfae(compact);
+   CompactStateMachine serial = nfae.translateToDFA(compact);
+   CompactStateMachine parallel = nfae.translateToDFAParallel(compact, pool);
+   vector<unique_ptr<CompiledDfa>> engines;
+   engines.emplace_back(new CompiledDfa(serial));
+   engines.emplace_back(new CompiledDfa(serial, true));
+   engines.emplace_back(new CompiledDfa(parallel));
+   engines.emplace_back(new CompiledDfa(parallel, true));
+   string path = "enginecheck." + to_string(getpid()) + ".cdfa";
+   for(bool verify : {true, false})
+   {
+      if(!engines[1]->save(path))
+      {
+         checker.expect("CompiledDfa::save", machine, "", true, false);
+         continue;
+      }
+      unique_ptr<CompiledDfa> loaded = CompiledDfa::load(path, verify);
+      checker.expect("CompiledDfa::load", machine, "", true,
+         loaded != nullptr);
+      if(loaded)
+      {
+         engines.push_back(move(loaded));
+      }
+   }
+   remove(path.c_str());
+
+   vector<string_view> views(inputs.begin(), inputs.end());
+   unique_ptr<bool[]> results(new bool[inputs.size()]);
+   for(const unique_ptr<CompiledDfa>& dfa : engines)
+   {
+      JitDfa jit(*dfa);
+      DfaStreamMatcher stream(*dfa);
+      for(size_t i = 0; i < inputs.size(); ++i)
+      {
+         checker.expect("CompiledDfa", machine, inputs[i], expected[i],
+            dfa->checkString(inputs[i]));
+         checker.expect("JitDfa", machine, inputs[i], expected[i],
+            jit.checkString(inputs[i]));
+         checker.expect("DfaStreamMatcher", machine, inputs[i], expected[i],
+            feedPieces(stream, inputs[i], random));
+      }
+      for(CompiledDfa::InterleaveMode mode : modes)
+      {
+         dfa->checkStrings(views.data(), views.size(), results.get(), mode);
+         for(size_t i = 0; i < inputs.size(); ++i)
+         {
+            checker.expect("CompiledDfa::checkStrings", machine, inputs[i],
+               expected[i], results[i]);
+         }
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// checkDuplicates(Checker& checker, int machine, const FiniteStateMachine& fsm,
+// const vector<string>& inputs)
+// fsm without its EPSILON transitions, read as a DFA: where a node has more
+// than one transition on a character the first one wins, whether or not
+// the CompiledDfa is minimized.  The reference runs on fsm with the later
+// duplicates taken out.
+//------------------------------------------------------------------------------
+static void checkDuplicates(Checker& checker, int machine,
+   const FiniteStateMachine& fsm, const vector<string>& inputs)
+{
+   FiniteStateMachine dfa = fsm;
+   FiniteStateMachine firstOnly = fsm;
+   dfa.transitions.clear();
+   firstOnly.transitions.clear();
+   set<pair<int, char>> seen;
+   for(const Transition& transition : fsm.transitions)
+   {
+      if(transition.isEpsilon)
+      {
+         continue;
+      }
+      dfa.transitions.push_back(transition);
+      if(seen.insert(make_pair(transition.source,
+         transition.transitionChar)).second)
+      {
+         firstOnly.transitions.push_back(transition);
+      }
+   }
+   Reference reference(firstOnly);
+   CompiledDfa plain(dfa);
+   CompiledDfa minimized(dfa, true);
+   for(const string& input : inputs)
+   {
+      bool expected = reference.matches(input);
+      checker.expect("CompiledDfa duplicates", machine, input, expected,
+         plain.checkString(input));
+      checker.expect("CompiledDfa minimized duplicates", machine, input,
+         expected, minimized.checkString(input));
+   }
+}
+
+//------------------------------------------------------------------------------
+// checkParallel(Checker& checker, int machine, const FiniteStateMachine& fsm,
+// WorkStealingPool& pool, mt19937& random)
+// checkStringParallel() on inputs long enough to be split into chunks, one
+// of 'a' only, which keeps machines with an 'a' ring alive to the end, and
+// one mostly of 'a'.  The reference is too slow for inputs this long, so
+// the serial CompiledDfa and the bit parallel NFA, checked above on short
+// inputs, stand in for it.
+//------------------------------------------------------------------------------
+static void checkParallel(Checker& checker, int machine,
+   const FiniteStateMachine& fsm, WorkStealingPool& pool, mt19937& random)
+{
+   static const char alphabet[] = {'a', 'a', 'a', 'a', 'a', 'a', 'a', 'b',
+      '\0'};
+   CompiledNfaEpsilon nfae(fsm);
+   CompiledDfa dfa(nfae.translateToCompactDFA());
+   string input(PARALLEL_LENGTH, 'a');
+   for(int round = 0; round < 2; ++round)
+   {
+      bool expected = nfae.checkString(input);
+      string label = "long input " + to_string(round);
+      checker.expect("CompiledDfa", machine, label, expected,
+         dfa.checkString(input));
+      checker.expect("CompiledDfa::checkStringParallel", machine, label,
+         expected, dfa.checkStringParallel(input, pool));
+      for(char& inputChar : input)
+      {
+         if(random() % 64 == 0)
+         {
+            inputChar = alphabet[random() % 9];
+         }
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// checkPatternSet(Checker& checker, int machine, const FiniteStateMachine& fsm,
+// const vector<string>& inputs, mt19937& random)
+// A PatternSet of fsm and a second random machine, built from either
+// representation, against the reference of each rule.
+//------------------------------------------------------------------------------
+static void checkPatternSet(Checker& checker, int machine,
+   const FiniteStateMachine& fsm, const vector<string>& inputs,
+   mt19937& random)
+{
+   vector<FiniteStateMachine> rules = {fsm, randomMachine(random)};
+   vector<CompactStateMachine> compactRules(rules.begin(), rules.end());
+   Reference first(rules[0]);
+   Reference second(rules[1]);
+   PatternSet patterns(rules);
+   PatternSet compactPatterns(compactRules);
+   for(const string& input : inputs)
+   {
+      vector<int> expected;
+      if(first.matches(input))
+      {
+         expected.push_back(0);
+      }
+      if(second.matches(input))
+      {
+         expected.push_back(1);
+      }
+      checker.expect("PatternSet", machine, input, true,
+         patterns.matchingRules(input) == expected);
+      checker.expect("PatternSet compact", machine, input, true,
+         compactPatterns.matchingRules(input) == expected);
+   }
+}
+
+//------------------------------------------------------------------------------
+// checkSearcher(Checker& checker, int machine, const FiniteStateMachine& fsm,
+// const CompactStateMachine& compact, const vector<string>& inputs,
+// mt19937& random)
+// Searchers built from every representation against the leftmost-longest
+// matches the reference finds by trying every start: findAll(), find() from
+// a random position, and a Cursor from there.  JitDfa searches through a
+// Searcher of its own, so it is checked too.
+//------------------------------------------------------------------------------
+static void checkSearcher(Checker& checker, int machine,
+   const FiniteStateMachine& fsm, const CompactStateMachine& compact,
+   const vector<string>& inputs, mt19937& random)
+{
+   Reference reference(fsm);
+   CompiledNfaEpsilon nfae(compact);
+   CompiledDfa dfa(nfae.translateToCompactDFA());
+   JitDfa jit(dfa);
+   vector<Searcher> engines;
+   engines.emplace_back(fsm);
+   engines.emplace_back(compact);
+   engines.emplace_back(dfa);
+   engines.emplace_back(nfae);
+   for(int i = 0; i < SEARCH_INPUTS && i < int(inputs.size()); ++i)
+   {
+      const string& input = inputs[i];
+      size_t from = random() % (input.size() + 1);
+      vector<Searcher::Match> all;
+      vector<Searcher::Match> fromMatches;
+      for(size_t pos = 0; pos <= input.size(); )
+      {
+         size_t end = reference.longestMatch(input, pos);
+         if(end == string::npos)
+         {
+            ++pos;
+            continue;
+         }
+         all.push_back(Searcher::Match{pos, end});
+         pos = (end > pos) ? end : pos + 1;
+      }
+      for(size_t pos = from; pos <= input.size(); )
+      {
+         size_t end = reference.longestMatch(input, pos);
+         if(end == string::npos)
+         {
+            ++pos;
+            continue;
+         }
+         fromMatches.push_back(Searcher::Match{pos, end});
+         pos = (end > pos) ? end : pos + 1;
+      }
+      for(const Searcher& searcher : engines)
+      {
+         checker.expect("Searcher::findAll", machine, input, true,
+            sameMatches(searcher.findAll(input), all));
+         Searcher::Match match;
+         bool found = searcher.find(input, from, match);
+         checker.expect("Searcher::find", machine, input, true,
+            found == !fromMatches.empty() && (!found ||
+            sameMatches(vector<Searcher::Match>{match},
+               vector<Searcher::Match>{fromMatches[0]})));
+         Searcher::Cursor cursor(searcher, input, from);
+         vector<Searcher::Match> cursorMatches;
+         while(cursor.next(match))
+         {
+            cursorMatches.push_back(match);
+         }
+         checker.expect("Searcher::Cursor", machine, input, true,
+            sameMatches(cursorMatches, fromMatches));
+      }
+      checker.expect("JitDfa::findAll", machine, input, true,
+         sameMatches(jit.findAll(input), all));
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   unsigned seed = 1;
+   int machines = 2000;
+   for(int arg = 1; arg < argc; ++arg)
+   {
+      if(strncmp(argv[arg], "--seed=", 7) == 0)
+      {
+         seed = static_cast<unsigned>(strtoul(argv[arg] + 7, nullptr, 10));
+      }
+      else if(strncmp(argv[arg], "--machines=", 11) == 0)
+      {
+         machines = atoi(argv[arg] + 11);
+      }
+      else
+      {
+         fprintf(stderr, "usage: %s [--seed=N] [--machines=N]\n", argv[0]);
+         return 2;
+      }
+   }
+
+   mt19937 random(seed);
+   Checker checker;
+   WorkStealingPool pool(4);
+   for(int machine = 0; machine < machines; ++machine)
+   {
+      //Machine 0 is the empty CompactStateMachine, whose FiniteStateMachine
+      //is a lone start node
+      FiniteStateMachine fsm;
+      CompactStateMachine compact;
+      if(machine == 0)
+      {
+         fsm.nodes.insert(0);
+         fsm.startNode = 0;
+      }
+      else
+      {
+         fsm = randomMachine(random);
+         compact = CompactStateMachine(fsm);
+      }
+      vector<string> inputs = randomInputs(random);
+      Reference reference(fsm);
+      vector<bool> expected;
+      for(const string& input : inputs)
+      {
+         expected.push_back(reference.matches(input));
+      }
+      checkNfa(checker, machine, fsm, compact, inputs, expected, random);
+      checkDfa(checker, machine, compact, inputs, expected, pool, random);
+      checkDuplicates(checker, machine, fsm, inputs);
+      checkLazyDfa(checker, machine, fsm, inputs, expected);
+      checkPatternSet(checker, machine, fsm, inputs, random);
+      checkSearcher(checker, machine, fsm, compact, inputs, random);
+      if(machine % PARALLEL_EVERY == 1)
+      {
+         checkParallel(checker, machine, fsm, pool, random);
+      }
+   }
+   printf("{\"checked\": %ld, \"mismatches\": %ld}\n", checker.checked,
+      checker.mismatches);
+   return checker.mismatches == 0 ? 0 : 1;
+}
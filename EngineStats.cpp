@@ -0,0 +1,162 @@
+//------------------------------------------------------------------------------
+// EngineStats.cpp
+// agent
+// 17 October 2026
+// Implementation for EngineStats.h
+// Contains implementation for:
+//    StatHistogram::reset()
+//    StatHistogram::toJson()
+//    DfaStats::reset()
+//    DfaStats::toJson()
+//    NfaStats::reset()
+//    NfaStats::toJson()
+//    TranslationStats::reset()
+//    TranslationStats::toJson()
+//------------------------------------------------------------------------------
+#include "EngineStats.h"
+#include <sstream>
+
+//------------------------------------------------------------------------------
+// StatHistogram::reset()
+// Empties every bucket.
+//------------------------------------------------------------------------------
+void StatHistogram::reset(void)
+{
+   for(StatCounter& bucket : buckets)
+   {
+      bucket.reset();
+   }
+}
+
+//------------------------------------------------------------------------------
+// StatHistogram::toJson()
+// Writes the non-empty buckets in ascending order, each with the smallest
+// and largest value it holds.
+//------------------------------------------------------------------------------
+string StatHistogram::toJson(void) const
+{
+   ostringstream json;
+   json << "[";
+   bool first = true;
+   for(int bucket = 0; bucket < BUCKETS; ++bucket)
+   {
+      uint64_t count = buckets[bucket].value();
+      if(count == 0)
+      {
+         continue;
+      }
+      uint64_t min = (bucket == 0) ? 0 : uint64_t(1) << (bucket - 1);
+      uint64_t max = (bucket == 0) ? 0 : min + (min - 1);
+      json << (first ? "" : ", ") << "{\"min\": " << min << ", \"max\": "
+         << max << ", \"count\": " << count << "}";
+      first = false;
+   }
+   json << "]";
+   return json.str();
+}
+
+//------------------------------------------------------------------------------
+// DfaStats::reset()
+// Sets every counter back to zero.
+//------------------------------------------------------------------------------
+void DfaStats::reset(void)
+{
+   matches.reset();
+   accepted.reset();
+   bytesProcessed.reset();
+   statesVisited.reset();
+   deadStateRejections.reset();
+   earlyAccepts.reset();
+}
+
+//------------------------------------------------------------------------------
+// DfaStats::toJson()
+// Writes every counter, plus whether statistics were compiled in at all.
+//------------------------------------------------------------------------------
+string DfaStats::toJson(void) const
+{
+   ostringstream json;
+   json << "{\"enabled\": " << (STATS_ENABLED ? "true" : "false")
+      << ", \"matches\": " << matches.value()
+      << ", \"accepted\": " << accepted.value()
+      << ", \"bytes_processed\": " << bytesProcessed.value()
+      << ", \"states_visited\": " << statesVisited.value()
+      << ", \"dead_state_rejections\": " << deadStateRejections.value()
+      << ", \"early_accepts\": " << earlyAccepts.value()
+      << "}";
+   return json.str();
+}
+
+//------------------------------------------------------------------------------
+// NfaStats::reset()
+// Sets every counter and histogram back to zero.
+//------------------------------------------------------------------------------
+void NfaStats::reset(void)
+{
+   matches.reset();
+   accepted.reset();
+   bytesProcessed.reset();
+   steps.reset();
+   deadStateRejections.reset();
+   activeNodesTotal.reset();
+   activeNodesMax.reset();
+   activeSetSizes.reset();
+   rejectionDepth.reset();
+}
+
+//------------------------------------------------------------------------------
+// NfaStats::toJson()
+// Writes every counter and histogram, plus whether statistics were compiled
+// in at all.
+//------------------------------------------------------------------------------
+string NfaStats::toJson(void) const
+{
+   ostringstream json;
+   json << "{\"enabled\": " << (STATS_ENABLED ? "true" : "false")
+      << ", \"matches\": " << matches.value()
+      << ", \"accepted\": " << accepted.value()
+      << ", \"bytes_processed\": " << bytesProcessed.value()
+      << ", \"steps\": " << steps.value()
+      << ", \"dead_state_rejections\": " << deadStateRejections.value()
+      << ", \"active_nodes_total\": " << activeNodesTotal.value()
+      << ", \"active_nodes_max\": " << activeNodesMax.value()
+      << ", \"active_set_sizes\": " << activeSetSizes.toJson()
+      << ", \"rejection_depth\": " << rejectionDepth.toJson()
+      << "}";
+   return json.str();
+}
+
+//------------------------------------------------------------------------------
+// TranslationStats::reset()
+// Sets every counter and histogram back to zero.
+//------------------------------------------------------------------------------
+void TranslationStats::reset(void)
+{
+   translations.reset();
+   nodeSetsCreated.reset();
+   duplicatesHit.reset();
+   emptySets.reset();
+   largestNodeSet.reset();
+   translationNanos.reset();
+   expansionNanos.reset();
+}
+
+//------------------------------------------------------------------------------
+// TranslationStats::toJson()
+// Writes every counter and histogram, plus whether statistics were compiled
+// in at all.
+//------------------------------------------------------------------------------
+string TranslationStats::toJson(void) const
+{
+   ostringstream json;
+   json << "{\"enabled\": " << (STATS_ENABLED ? "true" : "false")
+      << ", \"translations\": " << translations.value()
+      << ", \"node_sets_created\": " << nodeSetsCreated.value()
+      << ", \"duplicates_hit\": " << duplicatesHit.value()
+      << ", \"empty_sets\": " << emptySets.value()
+      << ", \"largest_node_set\": " << largestNodeSet.value()
+      << ", \"translation_nanos\": " << translationNanos.toJson()
+      << ", \"expansion_nanos\": " << expansionNanos.toJson()
+      << "}";
+   return json.str();
+}
@@ -0,0 +1,283 @@
+//------------------------------------------------------------------------------
+// EngineStats.h
+// agent
+// 17 October 2026
+// Optional run time statistics of the matching engines and translators
+//------------------------------------------------------------------------------
+#ifndef ENGINESTATS_H
+#define ENGINESTATS_H
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// Statistics are only gathered when the project is compiled with
+// -DFA_ENABLE_STATS.  Otherwise STATS_ENABLED is false, every record method
+// below returns at once and, being inline, compiles away along with the
+// work done to compute its arguments, so matching costs what it did before.
+// The counters are still there and read as zero.
+//------------------------------------------------------------------------------
+#ifdef FA_ENABLE_STATS
+const bool STATS_ENABLED = true;
+#else
+const bool STATS_ENABLED = false;
+#endif
+
+//------------------------------------------------------------------------------
+// StatCounter Class
+// A relaxed atomic counter, so engines shared between threads can count
+// without locks.  Copying one copies its current value, which is what makes
+// a copy of a stats struct a snapshot.
+// Public methods:
+//    add()
+//    raise()
+//    value()
+//    reset()
+// Members:
+//    count
+//------------------------------------------------------------------------------
+class StatCounter
+{
+   public:
+      StatCounter() : count(0) {}
+      StatCounter(const StatCounter& other) : count(other.value()) {}
+      StatCounter& operator=(const StatCounter& other)
+         {count.store(other.value(), memory_order_relaxed); return *this;}
+
+      //Adds amount to the counter
+      inline void add(uint64_t amount)
+         {count.fetch_add(amount, memory_order_relaxed);}
+
+      //Raises the counter to candidate if that is larger, for maximums
+      inline void raise(uint64_t candidate)
+         {uint64_t cur = value();
+          while(candidate > cur &&
+             !count.compare_exchange_weak(cur, candidate,
+                memory_order_relaxed)) {}}
+
+      //Current value
+      inline uint64_t value(void) const
+         {return count.load(memory_order_relaxed);}
+
+      //Sets the counter back to zero
+      inline void reset(void) {count.store(0, memory_order_relaxed);}
+
+   private:
+      atomic<uint64_t> count;
+};
+
+//------------------------------------------------------------------------------
+// StatHistogram Class
+// Counts recorded values in power of two buckets: bucket 0 holds 0 and
+// bucket b holds 2^(b - 1) .. 2^b - 1.
+// Public methods:
+//    record()
+//    bucketCount()
+//    reset()
+//    toJson()
+// Members:
+//    buckets
+//------------------------------------------------------------------------------
+class StatHistogram
+{
+   public:
+      static constexpr int BUCKETS = 65;     //0, then one per bit length
+
+      //Counts value in its bucket
+      inline void record(uint64_t value)
+         {buckets[value ? 64 - __builtin_clzll(value) : 0].add(1);}
+
+      //Number of values recorded in bucket
+      inline uint64_t bucketCount(int bucket) const
+         {return buckets[bucket].value();}
+
+      //Empties every bucket
+      void reset(void);
+
+      //Array of {"min", "max", "count"} objects, one per non-empty bucket
+      string toJson(void) const;
+
+   private:
+      StatCounter buckets[BUCKETS];
+};
+
+//------------------------------------------------------------------------------
+// StatTimer Class
+// Reads the clock at construction, only if STATS_ENABLED, so timing hooks
+// cost nothing in a build without statistics.
+// Public methods:
+//    elapsedNanos()
+// Members:
+//    begin
+//------------------------------------------------------------------------------
+class StatTimer
+{
+   public:
+      StatTimer()
+         {if(STATS_ENABLED) {begin = chrono::steady_clock::now();}}
+
+      //Nanoseconds since construction, 0 without STATS_ENABLED
+      inline uint64_t elapsedNanos(void) const
+         {return STATS_ENABLED ? static_cast<uint64_t>(
+             chrono::duration_cast<chrono::nanoseconds>(
+                chrono::steady_clock::now() - begin).count()) : 0;}
+
+   private:
+      chrono::steady_clock::time_point begin;
+};
+
+//------------------------------------------------------------------------------
+// struct DfaStats
+// Statistics of a CompiledDfa:
+//    matches              - inputs matched with checkString() or
+//                           checkStrings()
+//    accepted             - those that matched
+//    bytesProcessed       - input bytes offered, including pieces passed to
+//                           advance() but not the chunks checkStringParallel()
+//                           runs from every state
+//    statesVisited        - transitions taken; short of bytesProcessed by
+//                           the bytes skipped after reaching the dead state
+//                           or the accepting sink
+//    deadStateRejections  - walks that stopped early at the dead state
+//    earlyAccepts         - walks that stopped early at the accepting sink
+//------------------------------------------------------------------------------
+struct DfaStats
+{
+   StatCounter matches;
+   StatCounter accepted;
+   StatCounter bytesProcessed;
+   StatCounter statesVisited;
+   StatCounter deadStateRejections;
+   StatCounter earlyAccepts;
+
+   //Records one walk over length bytes that took visited transitions and
+   //ended in the dead state or the accepting sink
+   inline void recordWalk(size_t length, size_t visited, bool dead,
+      bool sink = false)
+      {if(!STATS_ENABLED) {return;}
+       bytesProcessed.add(length); statesVisited.add(visited);
+       if(dead && visited < length) {deadStateRejections.add(1);}
+       if(sink && visited < length) {earlyAccepts.add(1);}}
+
+   //Records count whole inputs, acceptedCount of which matched
+   inline void recordMatches(size_t count, size_t acceptedCount)
+      {if(!STATS_ENABLED) {return;}
+       matches.add(count); accepted.add(acceptedCount);}
+
+   //Sets every counter back to zero
+   void reset(void);
+
+   //JSON object of every counter
+   string toJson(void) const;
+};
+
+//------------------------------------------------------------------------------
+// struct NfaStats
+// Statistics of CompiledNfaEpsilon matching:
+//    matches              - inputs matched with checkString()
+//    accepted             - those that matched
+//    bytesProcessed       - input bytes offered, including pieces passed to
+//                           advanceMatch()
+//    steps                - input bytes the active set was advanced over
+//    deadStateRejections  - walks that stopped early once no node was active
+//    activeNodesTotal     - active set size summed over every step, so
+//                           activeNodesTotal / steps is the mean size
+//    activeNodesMax       - largest active set seen
+//    activeSetSizes       - histogram of the active set size at every step
+//    rejectionDepth       - histogram of how many bytes a rejected walk got
+//                           through.  The simulation never backtracks, so
+//                           this is the depth at which it gave up instead.
+//------------------------------------------------------------------------------
+struct NfaStats
+{
+   StatCounter matches;
+   StatCounter accepted;
+   StatCounter bytesProcessed;
+   StatCounter steps;
+   StatCounter deadStateRejections;
+   StatCounter activeNodesTotal;
+   StatCounter activeNodesMax;
+   StatHistogram activeSetSizes;
+   StatHistogram rejectionDepth;
+
+   //Records the size of the active set after one step
+   inline void recordActiveSet(size_t activeNodes)
+      {if(!STATS_ENABLED) {return;}
+       activeNodesTotal.add(activeNodes); activeNodesMax.raise(activeNodes);
+       activeSetSizes.record(activeNodes);}
+
+   //Records one walk over length bytes that took stepCount steps
+   inline void recordWalk(size_t length, size_t stepCount, bool dead)
+      {if(!STATS_ENABLED) {return;}
+       bytesProcessed.add(length); steps.add(stepCount);
+       if(dead) {deadStateRejections.add(1);
+          rejectionDepth.record(stepCount);}}
+
+   //Records one whole input and whether it matched
+   inline void recordMatch(bool isAccepted)
+      {if(!STATS_ENABLED) {return;}
+       matches.add(1); accepted.add(isAccepted ? 1 : 0);}
+
+   //Sets every counter back to zero
+   void reset(void);
+
+   //JSON object of every counter and histogram
+   string toJson(void) const;
+};
+
+//------------------------------------------------------------------------------
+// struct TranslationStats
+// Statistics of the subset constructions of a CompiledNfaEpsilon, serial
+// and parallel alike:
+//    translations         - translateToDFA() and translateToDFAParallel()
+//                           calls
+//    nodeSetsCreated      - distinct node sets, i.e. dfa nodes, created
+//    duplicatesHit        - destination sets that were already known
+//    emptySets            - destination sets that were empty, which need no
+//                           dfa transition
+//    largestNodeSet       - most nfae nodes in one dfa node
+//    translationNanos     - histogram of whole translation times
+//    expansionNanos       - histogram of the time spent finding every
+//                           destination set of one node set
+//------------------------------------------------------------------------------
+struct TranslationStats
+{
+   StatCounter translations;
+   StatCounter nodeSetsCreated;
+   StatCounter duplicatesHit;
+   StatCounter emptySets;
+   StatCounter largestNodeSet;
+   StatHistogram translationNanos;
+   StatHistogram expansionNanos;
+
+   //Records one destination set: empty, new with nodeCount nodes, or known
+   inline void recordNodeSet(size_t nodeCount, bool isNew)
+      {if(!STATS_ENABLED) {return;}
+       if(nodeCount == 0) {emptySets.add(1);}
+       else if(isNew) {nodeSetsCreated.add(1);
+          largestNodeSet.raise(nodeCount);}
+       else {duplicatesHit.add(1);}}
+
+   //Records the expansion of one node set, timed by timer
+   inline void recordExpansion(const StatTimer& timer)
+      {if(!STATS_ENABLED) {return;}
+       expansionNanos.record(timer.elapsedNanos());}
+
+   //Records one finished translation, timed by timer
+   inline void recordTranslation(const StatTimer& timer)
+      {if(!STATS_ENABLED) {return;}
+       translations.add(1);
+       translationNanos.record(timer.elapsedNanos());}
+
+   //Sets every counter back to zero
+   void reset(void);
+
+   //JSON object of every counter and histogram
+   string toJson(void) const;
+};
+
+#endif // ENGINESTATS_H
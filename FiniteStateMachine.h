@@ -12,24 +12,38 @@
 
 using namespace std;
 
-const char EPSILON = '\x0';   //used for epsilon transitions
+//------------------------------------------------------------------------------
+// Type of EPSILON, the label of epsilon transitions.  Epsilon is kept out of
+// band instead of reserving a char for it, so every char, NUL included, can
+// label an ordinary transition:
+//    fsm.transitions.emplace_back(0, EPSILON, 1);
+//------------------------------------------------------------------------------
+struct EpsilonSymbol {};
+const EpsilonSymbol EPSILON = EpsilonSymbol();   //used for epsilon transitions
 
 //------------------------------------------------------------------------------
 // Stores basic information about a transition.
 // Contains constructors and an assignment operator overload - added by John
 // Wehrle for convenience in the CompiledNfaEpsilon class.
+// isEpsilon is set by the EPSILON constructor only; transitionChar means
+// nothing on an epsilon transition.
 //------------------------------------------------------------------------------
 struct Transition
 {
    int source;
    char transitionChar;
    int destination;
-   Transition() :  source(0), transitionChar('0'), destination(0) {}
+   bool isEpsilon;
+   Transition() :  source(0), transitionChar('0'), destination(0),
+      isEpsilon(false) {}
    Transition(int from, char with, int to) :
-      source(from), transitionChar(with), destination(to) {}
+      source(from), transitionChar(with), destination(to), isEpsilon(false) {}
+   Transition(int from, EpsilonSymbol, int to) :
+      source(from), transitionChar('\x0'), destination(to), isEpsilon(true) {}
    Transition& operator=(const Transition& other)
       {source = other.source; transitionChar = other.transitionChar;
-       destination = other.destination; return *this;}
+       destination = other.destination; isEpsilon = other.isEpsilon;
+       return *this;}
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,402 @@
+//------------------------------------------------------------------------------
+// JitDfa.cpp
+// agent
+// 17 October 2026
+// Implementation for JitDfa.h
+// Contains implementation for:
+//    struct CodeBuffer
+//    Constructor
+//    compile()
+//    emitState()
+//    longestMatchEnd()
+//------------------------------------------------------------------------------
+#include "JitDfa.h"
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define JITDFA_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define JITDFA_X86_64 0
+#endif
+
+//------------------------------------------------------------------------------
+// struct CodeBuffer
+// Machine code under construction.  Jumps and rip-relative addresses name a
+// label and are patched by link() once every label is bound, so code can
+// jump forward to blocks not emitted yet.  Jump table entries are the
+// offset of their target from the start of the table.
+//------------------------------------------------------------------------------
+struct JitDfa::CodeBuffer
+{
+   vector<unsigned char> bytes;
+   vector<long> labels;                      //Offset of each label, or -1
+   vector<pair<size_t, int>> fixups;         //rel32 field, label
+   vector<pair<size_t, pair<int, int>>> entries;  //entry, table, target
+
+   //Returns a new unbound label
+   inline int newLabel(void)
+      {labels.push_back(-1); return static_cast<int>(labels.size()) - 1;}
+
+   //Binds label to the current end of the code
+   inline void bind(int label) {labels[label] = bytes.size();}
+
+   //Appends raw bytes
+   inline void emit(initializer_list<unsigned char> code)
+      {bytes.insert(bytes.end(), code);}
+
+   //Appends a little endian 32 bit value
+   inline void emit32(int32_t value)
+      {uint32_t bits = static_cast<uint32_t>(value);
+       for(int shift = 0; shift < 32; shift += 8)
+       {bytes.push_back(static_cast<unsigned char>(bits >> shift));}}
+
+   //Appends a rel32 field that will hold the distance to label from the
+   //end of the field, as jumps and rip-relative operands expect
+   inline void rel32(int label)
+      {fixups.emplace_back(bytes.size(), label); emit32(0);}
+
+   //Appends a jump table entry of table, itself a label, leading to target
+   inline void entry(int table, int target)
+      {entries.emplace_back(bytes.size(), make_pair(table, target));
+       emit32(0);}
+
+   //Pads with int3 up to a multiple of alignment
+   inline void align(size_t alignment)
+      {while(bytes.size() % alignment) {bytes.push_back(0xCC);}}
+
+   //Patches every fixup and entry
+   void link(void)
+   {
+      for(const pair<size_t, int>& fixup : fixups)
+      {
+         patch(fixup.first, labels[fixup.second] -
+            static_cast<long>(fixup.first + 4));
+      }
+      for(const pair<size_t, pair<int, int>>& tableEntry : entries)
+      {
+         patch(tableEntry.first, labels[tableEntry.second.second] -
+            labels[tableEntry.second.first]);
+      }
+   }
+
+   //Overwrites the 32 bit value at position
+   inline void patch(size_t position, long value)
+      {uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(value));
+       for(int shift = 0; shift < 32; shift += 8)
+       {bytes[position++] = static_cast<unsigned char>(bits >> shift);}}
+};
+
+//------------------------------------------------------------------------------
+// Constructs a JitDfa from compiled, sharing its tables.  The Searcher of
+// find() and findAll() is left for searcher() to build.
+// Calls:
+//    compile()
+//------------------------------------------------------------------------------
+JitDfa::JitDfa(const CompiledDfa& compiled)
+: dfa(compiled), matchCode(nullptr), longestCode(nullptr),
+  search(make_shared<LazySearcher>())
+{
+   compile();
+}
+
+//------------------------------------------------------------------------------
+// compile()
+// Generates two System V functions taking begin in rdi and end in rsi, one
+// block per undecided state reachable from the start state for each:
+//    match   - returns in eax whether the state at the end is a goal, or
+//              false as soon as the dead state is reached and true as soon
+//              as the accepting sink is
+//    longest - keeps the position after the last goal state in rdx and
+//              returns it at the end of input or at the dead state, or
+//              returns end once the accepting sink is reached
+// Both first load the address of a copy of the byte class table into r8.
+// The code, jump tables and class table are copied into a fresh read-write
+// mapping that is then made read-execute; if either step fails, matchCode
+// stays null and the CompiledDfa is used.
+// Calls:
+//    emitState()
+//------------------------------------------------------------------------------
+void JitDfa::compile(void)
+{
+#if JITDFA_X86_64
+   int stateCount = dfa.size();
+   vector<char> reached(stateCount, 0);
+   vector<int> order;
+   if(!dfa.isDecidedState(dfa.startState()))
+   {
+      reached[dfa.startState()] = 1;
+      order.push_back(dfa.startState());
+   }
+   vector<int> representative(dfa.classes(), -1);
+   for(int byte = 255; byte >= 0; --byte)
+   {
+      representative[dfa.classOf(static_cast<unsigned char>(byte))] = byte;
+   }
+   for(size_t next = 0; next < order.size(); ++next)
+   {
+      for(int byteCls = 0; byteCls < dfa.classes(); ++byteCls)
+      {
+         int dest = dfa.nextState(order[next], representative[byteCls]);
+         if(!dfa.isDecidedState(dest) && !reached[dest])
+         {
+            reached[dest] = 1;
+            order.push_back(dest);
+         }
+      }
+   }
+
+   CodeBuffer buffer;
+   int retTrue = buffer.newLabel();
+   int retFalse = buffer.newLabel();
+   int retLast = buffer.newLabel();
+   int retEnd = buffer.newLabel();
+   int classTable = buffer.newLabel();
+   int functions[2];
+   for(int longest = 0; longest < 2; ++longest)
+   {
+      vector<int> stateLabels(stateCount, -1);
+      for(int state : order)
+      {
+         stateLabels[state] = buffer.newLabel();
+      }
+      buffer.align(16);
+      functions[longest] = buffer.newLabel();
+      buffer.bind(functions[longest]);
+      buffer.emit({0x4C, 0x8D, 0x05});         //lea r8, [rip + classTable]
+      buffer.rel32(classTable);
+      if(longest)
+      {
+         buffer.emit({0x31, 0xD2});            //xor edx, edx
+      }
+      int deadLabel = longest ? retLast : retFalse;
+      int acceptLabel = longest ? retEnd : retTrue;
+      if(order.empty())
+      {
+         buffer.emit({0xE9});                  //jmp to the decided return
+         buffer.rel32(dfa.isAcceptState(dfa.startState()) ? acceptLabel :
+            deadLabel);
+      }
+      for(int state : order)
+      {
+         int endLabel = longest ? retLast :
+            (dfa.isGoalState(state) ? retTrue : retFalse);
+         emitState(buffer, state, stateLabels, endLabel, deadLabel,
+            acceptLabel, longest, representative);
+      }
+   }
+   buffer.bind(retTrue);
+   buffer.emit({0xB8, 0x01, 0x00, 0x00, 0x00, 0xC3});  //mov eax, 1; ret
+   buffer.bind(retFalse);
+   buffer.emit({0x31, 0xC0, 0xC3});                     //xor eax, eax; ret
+   buffer.bind(retLast);
+   buffer.emit({0x48, 0x89, 0xD0, 0xC3});               //mov rax, rdx; ret
+   buffer.bind(retEnd);
+   buffer.emit({0x48, 0x89, 0xF0, 0xC3});               //mov rax, rsi; ret
+   buffer.align(64);
+   buffer.bind(classTable);
+   for(int byte = 0; byte < 256; ++byte)
+   {
+      buffer.bytes.push_back(static_cast<unsigned char>(
+         dfa.classOf(static_cast<unsigned char>(byte))));
+   }
+   buffer.link();
+
+   size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+   size_t mapSize = (buffer.bytes.size() + pageSize - 1) / pageSize *
+      pageSize;
+   void* region = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if(region == MAP_FAILED)
+   {
+      return;
+   }
+   code = shared_ptr<void>(region, [mapSize](void* mapping)
+      {munmap(mapping, mapSize);});
+   memcpy(region, buffer.bytes.data(), buffer.bytes.size());
+   if(mprotect(region, mapSize, PROT_READ | PROT_EXEC) != 0)
+   {
+      code.reset();
+      return;
+   }
+   unsigned char* base = static_cast<unsigned char*>(region);
+   matchCode = reinterpret_cast<MatchFunction>(
+      base + buffer.labels[functions[0]]);
+   longestCode = reinterpret_cast<LongestFunction>(
+      base + buffer.labels[functions[1]]);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// emitState(CodeBuffer& buffer, int state, const vector<int>& stateLabels,
+// int endLabel, int deadLabel, int acceptLabel, bool recordGoals,
+// const vector<int>& representative)
+// The block of one state: with recordGoals a goal state first saves the
+// position in rdx.  At the end of input it jumps to endLabel, otherwise it
+// reads the next byte and dispatches on it.  The byte values, and the byte
+// classes, are split into runs of consecutive values with the same next
+// state; the next state with the most runs becomes the fall back jump.  If
+// at most MAX_INLINE_RUNS byte runs remain, as in a state that only looks
+// for a few bytes, they are tested inline on the byte itself, a single
+// value with cmp/je and a longer run with one unsigned range check.  Failing
+// that the byte's class is looked up and class runs are tested the same
+// way, or if there are still too many the block jumps through a table with
+// one entry per class, placed right after the jump, where execution never
+// falls into it.
+//------------------------------------------------------------------------------
+void JitDfa::emitState(CodeBuffer& buffer, int state,
+   const vector<int>& stateLabels, int endLabel, int deadLabel,
+   int acceptLabel, bool recordGoals,
+   const vector<int>& representative) const
+{
+   int classCount = dfa.classes();
+   vector<int> classTarget(classCount);
+   for(int byteCls = 0; byteCls < classCount; ++byteCls)
+   {
+      int dest = dfa.nextState(state, representative[byteCls]);
+      classTarget[byteCls] = dfa.isDeadState(dest) ? deadLabel :
+         (dfa.isAcceptState(dest) ? acceptLabel : stateLabels[dest]);
+   }
+   vector<int> byteTarget(256);
+   for(int byte = 0; byte < 256; ++byte)
+   {
+      byteTarget[byte] =
+         classTarget[dfa.classOf(static_cast<unsigned char>(byte))];
+   }
+
+   //Splits target into runs, first and last value, and returns the fall
+   //back target and the number of runs that do not lead to it
+   auto splitRuns = [](const vector<int>& target,
+      vector<pair<int, int>>& runs, int& fallback)
+   {
+      for(int value = 0; value < static_cast<int>(target.size()); ++value)
+      {
+         if(runs.empty() || target[runs.back().second] != target[value])
+         {
+            runs.emplace_back(value, value);
+         }
+         else
+         {
+            runs.back().second = value;
+         }
+      }
+      size_t fallbackRuns = 0;
+      for(const pair<int, int>& run : runs)
+      {
+         size_t count = 0;
+         for(const pair<int, int>& other : runs)
+         {
+            count += (target[other.first] == target[run.first]) ? 1 : 0;
+         }
+         if(count > fallbackRuns)
+         {
+            fallback = target[run.first];
+            fallbackRuns = count;
+         }
+      }
+      return runs.size() - fallbackRuns;
+   };
+
+   //Tests eax against every run not leading to fallback, then jumps to it
+   auto emitCompares = [&buffer](const vector<int>& target,
+      const vector<pair<int, int>>& runs, int fallback)
+   {
+      for(const pair<int, int>& run : runs)
+      {
+         if(target[run.first] == fallback)
+         {
+            continue;
+         }
+         if(run.first == run.second)
+         {
+            buffer.emit({0x3D});               //cmp eax, first
+            buffer.emit32(run.first);
+            buffer.emit({0x0F, 0x84});         //je target
+         }
+         else
+         {
+            buffer.emit({0x8D, 0x88});         //lea ecx, [rax - first]
+            buffer.emit32(-run.first);
+            buffer.emit({0x81, 0xF9});         //cmp ecx, last - first
+            buffer.emit32(run.second - run.first);
+            buffer.emit({0x0F, 0x86});         //jbe target
+         }
+         buffer.rel32(target[run.first]);
+      }
+      buffer.emit({0xE9});                     //jmp fallback
+      buffer.rel32(fallback);
+   };
+
+   buffer.bind(stateLabels[state]);
+   if(recordGoals && dfa.isGoalState(state))
+   {
+      buffer.emit({0x48, 0x89, 0xFA});         //mov rdx, rdi
+   }
+   buffer.emit({0x48, 0x39, 0xF7});            //cmp rdi, rsi
+   buffer.emit({0x0F, 0x83});                  //jae endLabel
+   buffer.rel32(endLabel);
+   buffer.emit({0x0F, 0xB6, 0x07});            //movzx eax, byte [rdi]
+   buffer.emit({0x48, 0xFF, 0xC7});            //inc rdi
+
+   vector<pair<int, int>> runs;
+   int fallback = deadLabel;
+   if(splitRuns(byteTarget, runs, fallback) <= size_t(MAX_INLINE_RUNS))
+   {
+      emitCompares(byteTarget, runs, fallback);
+      return;
+   }
+   buffer.emit({0x41, 0x0F, 0xB6, 0x04, 0x00}); //movzx eax, byte [r8 + rax]
+   runs.clear();
+   if(splitRuns(classTarget, runs, fallback) <= size_t(MAX_INLINE_RUNS))
+   {
+      emitCompares(classTarget, runs, fallback);
+      return;
+   }
+
+   int table = buffer.newLabel();
+   buffer.emit({0x48, 0x8D, 0x0D});            //lea rcx, [rip + table]
+   buffer.rel32(table);
+   buffer.emit({0x48, 0x63, 0x04, 0x81});      //movsxd rax, [rcx + rax * 4]
+   buffer.emit({0x48, 0x01, 0xC8});            //add rax, rcx
+   buffer.emit({0xFF, 0xE0});                  //jmp rax
+   buffer.align(4);
+   buffer.bind(table);
+   for(int byteCls = 0; byteCls < classCount; ++byteCls)
+   {
+      buffer.entry(table, classTarget[byteCls]);
+   }
+}
+
+//------------------------------------------------------------------------------
+// longestMatchEnd(const char* input, size_t begin, size_t length)
+// Runs the generated anchored search from begin, or walks the CompiledDfa
+// the same way if there is no generated code.
+//------------------------------------------------------------------------------
+size_t JitDfa::longestMatchEnd(const char* input, size_t begin,
+   size_t length) const
+{
+   const unsigned char* bytes = reinterpret_cast<const unsigned char*>(input);
+   if(longestCode)
+   {
+      const unsigned char* end = longestCode(bytes + begin, bytes + length);
+      return end ? static_cast<size_t>(end - bytes) : string_view::npos;
+   }
+   int state = dfa.startState();
+   size_t longestEnd = dfa.isGoalState(state) ? begin : string_view::npos;
+   for(size_t pos = begin; pos < length; ++pos)
+   {
+      if(dfa.isDecidedState(state))
+      {
+         return dfa.isAcceptState(state) ? length : longestEnd;
+      }
+      state = dfa.nextState(state, bytes[pos]);
+      if(dfa.isGoalState(state))
+      {
+         longestEnd = pos + 1;
+      }
+   }
+   return longestEnd;
+}
@@ -0,0 +1,203 @@
+//------------------------------------------------------------------------------
+// JitDfa.h
+// agent
+// 17 October 2026
+// Matches input strings with native code generated from a CompiledDfa at
+// run time
+//------------------------------------------------------------------------------
+#ifndef JITDFA_H
+#define JITDFA_H
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include "FiniteStateMachine.h"
+#include "CompactStateMachine.h"
+#include "CompiledDfa.h"
+#include "Searcher.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// JitDfa Class
+// The run time counterpart of DfaCodeGenerator, for machines that are only
+// known once the program runs.  On Linux/x86-64 the constructor writes x86-64
+// machine code for the DFA into an anonymous mmap() region, then flips the
+// region from writable to executable, so it is never both (W^X).  Each
+// reachable state becomes one basic block that stops at the end of input,
+// loads the next byte and its byte class, and jumps to the next state's
+// block: through a few inline compares when the state tells only a few runs
+// of byte classes apart, through a jump table of the state otherwise.
+// On other targets, or if the region cannot be made executable, the
+// CompiledDfa the code would have been generated from is used instead, so
+// results are the same everywhere; isCompiled() tells which one runs.
+// Like any direct-coded matcher it relies on branch prediction: it beats
+// the table engine on input that mostly takes the same few transitions,
+// such as text searched for rare words, and is several times slower on
+// input whose transitions look random, where every jump mispredicts.
+// No defaul constructor, instead can only be constructed with a
+// FiniteStateMachine or CompactStateMachine in DFA format, or with a
+// CompiledDfa, e.g. one returned by CompiledDfa::load().  Results equal those
+// of CompiledDfa::checkString().
+// Two functions are generated: one matches a whole input, the other returns
+// the end of the longest match starting at the beginning of its input, for
+// longestMatch().  find() and findAll() are those of a Searcher built from
+// the same DFA, so a search costs two linear scans plus the length of the
+// matches found; searcher() gives the Searcher itself, e.g. for a Cursor.
+// The Searcher determinizes the reversed DFA, which can take far longer
+// than generating code, so it is only built by the first search.
+// Apart from that one-time build, guarded by a once_flag, a JitDfa is never
+// modified after construction and the generated code keeps no state outside
+// registers, so one instance can be shared by any number of threads.
+// Copies share the generated code and the Searcher.
+// MatchContext is empty and only exists so that JitDfa can be used with
+// matchBatch() like CompiledDfa.
+// Public methods:
+//    checkString() x4
+//    longestMatch() x2
+//    find() x2
+//    findAll() x2
+//    searcher()
+//    isCompiled()
+// Private methods:
+//    compile()
+//    emitState()
+//    longestMatchEnd()
+// Members:
+//    dfa
+//    matchCode
+//    longestCode
+//    code
+//    search
+//------------------------------------------------------------------------------
+class JitDfa
+{
+   public:
+      //Scratch space for checkString() - generated code needs none
+      struct MatchContext {};
+
+      //One match, as reported by Searcher
+      typedef Searcher::Match Match;
+
+      //Constructor
+      JitDfa(const FiniteStateMachine& finStMch, bool minimize = false)
+         : JitDfa(CompiledDfa(finStMch, minimize)) {}
+
+      //Constructor from the contiguous representation
+      JitDfa(const CompactStateMachine& finStMch, bool minimize = false)
+         : JitDfa(CompiledDfa(finStMch, minimize)) {}
+
+      //Constructor from an existing CompiledDfa, whose tables are shared
+      explicit JitDfa(const CompiledDfa& compiled);
+
+      //Destructor - key word 'new' is not used.
+      ~JitDfa(){}
+
+      //Returns true if inputString matches the DFA
+      inline bool checkString(string_view inputString) const
+         {return checkString(inputString.data(), inputString.size());}
+
+      //Returns true if the raw byte span matches the DFA
+      inline bool checkString(const char* input, size_t length) const
+         {const unsigned char* begin =
+             reinterpret_cast<const unsigned char*>(input);
+          return matchCode ? matchCode(begin, begin + length) :
+             dfa.checkString(input, length);}
+
+      //Returns checkString() - context is unused
+      inline bool checkString(string_view inputString, MatchContext&) const
+         {return checkString(inputString.data(), inputString.size());}
+
+      //Returns checkString() for a raw byte span - context is unused
+      inline bool checkString(const char* input, size_t length,
+         MatchContext&) const
+         {return checkString(input, length);}
+
+      //Length of the longest prefix of inputString that matches, or npos
+      inline size_t longestMatch(string_view inputString) const
+         {return longestMatch(inputString.data(), inputString.size());}
+
+      //Length of the longest prefix of the byte span that matches, or npos
+      inline size_t longestMatch(const char* input, size_t length) const
+         {return longestMatchEnd(input, 0, length);}
+
+      //Finds the leftmost-longest match starting at or after from
+      inline bool find(string_view input, size_t from, Match& match) const
+         {return searcher().find(input, from, match);}
+
+      //Finds the leftmost-longest match starting at or after from
+      inline bool find(const char* input, size_t length, size_t from,
+         Match& match) const
+         {return searcher().find(input, length, from, match);}
+
+      //Returns every non-overlapping leftmost-longest match, in order
+      inline vector<Match> findAll(string_view input) const
+         {return searcher().findAll(input);}
+
+      //Fills matches with every non-overlapping leftmost-longest match
+      inline void findAll(const char* input, size_t length,
+         vector<Match>& matches) const
+         {searcher().findAll(input, length, matches);}
+
+      //Returns the Searcher that runs find() and findAll(), building it the
+      //first time
+      inline const Searcher& searcher(void) const
+         {call_once(search->built, [this]()
+            {search->searcher = make_unique<Searcher>(dfa);});
+          return *search->searcher;}
+
+      //Returns true if generated code runs, false if the table engine does
+      inline bool isCompiled(void) const {return matchCode != nullptr;}
+
+   private:
+      JitDfa(); //no default constructor
+
+      //Generated whole input match, over begin .. end - 1
+      typedef bool (*MatchFunction)(const unsigned char* begin,
+         const unsigned char* end);
+      //Generated anchored search: one past the last byte of the longest
+      //match starting at begin, or nullptr if there is none
+      typedef const unsigned char* (*LongestFunction)(
+         const unsigned char* begin, const unsigned char* end);
+
+      CompiledDfa dfa;              //Source of the code, and the fallback
+      MatchFunction matchCode;      //Generated matcher, nullptr if none
+      LongestFunction longestCode;  //Generated anchored search
+      shared_ptr<void> code;        //Owns the executable mapping
+
+//------------------------------------------------------------------------------
+// struct LazySearcher
+// The Searcher of find() and findAll(), built once by searcher().
+//------------------------------------------------------------------------------
+      struct LazySearcher
+      {
+         once_flag built;
+         unique_ptr<Searcher> searcher;
+      };
+      shared_ptr<LazySearcher> search;  //Shared by copies
+
+      //Machine code under construction, see JitDfa.cpp
+      struct CodeBuffer;
+
+      //Most runs of bytes, or of byte classes, a state tells apart with
+      //inline compares before it uses a jump table instead
+      static constexpr int MAX_INLINE_RUNS = 4;
+
+      //Generates and maps the code; leaves matchCode null if it cannot
+      void compile(void);
+
+      //Emits the block of state for the function whose block labels are
+      //stateLabels; endLabel, deadLabel and acceptLabel are its returns at
+      //the end of input, on the dead state and on the accepting sink
+      void emitState(CodeBuffer& buffer, int state,
+         const vector<int>& stateLabels, int endLabel, int deadLabel,
+         int acceptLabel, bool recordGoals,
+         const vector<int>& representative) const;
+
+      //Returns the end of the longest match starting at begin, or npos
+      size_t longestMatchEnd(const char* input, size_t begin,
+         size_t length) const;
+};
+
+#endif // JITDFA_H
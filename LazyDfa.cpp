@@ -0,0 +1,216 @@
+//------------------------------------------------------------------------------
+// LazyDfa.cpp
+// agent
+// 17 October 2026
+// Implementation for LazyDfa.h
+// Contains implementation for:
+//    Constructor
+//    isMatch()
+//    computeNextState()
+//    addState()
+//    flushCache()
+//    stepNodeSet()
+//    matchNodeSets()
+//------------------------------------------------------------------------------
+#include "LazyDfa.h"
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+// Constructs a LazyDfa based on the transition index of an NFA without
+// epsilon transitions, taking the index over.  Only the start node set is
+// built here; every DFA node is created during matching.
+//------------------------------------------------------------------------------
+LazyDfa::LazyDfa(TransitionIndex&& nfaeIndex, size_t budget)
+: index(move(nfaeIndex)), memoryBudget(budget), memoryUsed(0), flushes(0),
+  startState(DEAD_STATE), stepMarks(index.size(), 0), stepMark(0)
+{
+   startSet.assign(1, index.startNode());
+}
+
+//------------------------------------------------------------------------------
+// isMatch(const char* input, size_t length)
+// Runs input through the cached DFA nodes, computing missing transitions as
+// they are reached.  A flush invalidates every cached node, but
+// computeNextState() always returns a valid node of the rebuilt cache, so the
+// walk simply continues.  Too many flushes within one input switch the rest
+// of the input over to matchNodeSets().
+// Calls:
+//    addState()
+//    computeNextState()
+//    matchNodeSets()
+//------------------------------------------------------------------------------
+bool LazyDfa::isMatch(const char* input, size_t length)
+{
+   if(startState == DEAD_STATE)
+   {
+      startState = addState(startSet);
+   }
+   size_t flushesAtStart = flushes;
+   int curState = startState;
+   for(size_t pos = 0; pos < length; ++pos)
+   {
+      unsigned char inputChar = static_cast<unsigned char>(input[pos]);
+      int nextState = nextStates[curState * ALPHABET_SIZE + inputChar];
+      if(nextState == UNKNOWN_STATE)
+      {
+         if(flushes - flushesAtStart >= MAX_FLUSHES_PER_MATCH)
+         {
+            return matchNodeSets(stateSets.nodeSet(curState), input + pos,
+               length - pos);
+         }
+         nextState = computeNextState(curState, inputChar);
+      }
+      if(nextState == DEAD_STATE)
+      {
+         return false;
+      }
+      curState = nextState;
+   }
+   return goalStates[curState] != 0;
+}
+
+//------------------------------------------------------------------------------
+// computeNextState(int state, unsigned char inputChar)
+// Steps the NFA node set of state on inputChar and looks the result up in
+// the cache, adding it as a new DFA node if needed.  The transition is only
+// recorded if adding the node did not flush the cache, since state no longer
+// exists after a flush.
+// Calls:
+//    stepNodeSet()
+//    addState()
+//------------------------------------------------------------------------------
+int LazyDfa::computeNextState(int state, unsigned char inputChar)
+{
+   stepNodeSet(stateSets.nodeSet(state), inputChar, stepScratch);
+   int nextState = DEAD_STATE;
+   if(!stepScratch.empty())
+   {
+      nextState = stateSets.find(stepScratch);
+      if(nextState < 0)
+      {
+         size_t flushesBefore = flushes;
+         nextState = addState(stepScratch);
+         if(flushes != flushesBefore)
+         {
+            return nextState;
+         }
+      }
+   }
+   nextStates[state * ALPHABET_SIZE + inputChar] = nextState;
+   return nextState;
+}
+
+//------------------------------------------------------------------------------
+// addState(const NodeSet& nodeSet)
+// Returns the DFA node of nodeSet, caching it as a new node with an
+// UNKNOWN_STATE row if it has none, flushing the cache first if the node
+// would take memoryUsed over memoryBudget.  The cost of a node is its row,
+// its node set and roughly one hash map entry.  The start set can already
+// be cached when isMatch() re-adds it after a flush, since the walk that
+// flushed may have reached it again.
+// Calls:
+//    flushCache()
+//------------------------------------------------------------------------------
+int LazyDfa::addState(const NodeSet& nodeSet)
+{
+   int cached = stateSets.find(nodeSet);
+   if(cached >= 0)
+   {
+      return cached;
+   }
+   size_t cost = ALPHABET_SIZE * sizeof(int) + 2 * nodeSet.size() * sizeof(int)
+      + 64;
+   if(memoryUsed + cost > memoryBudget && !stateSets.empty())
+   {
+      flushCache();
+   }
+   int state = stateSets.intern(nodeSet).first;
+   nextStates.resize(nextStates.size() + ALPHABET_SIZE, UNKNOWN_STATE);
+   bool isGoal = false;
+   for(int node : nodeSet)
+   {
+      if(index.isGoal(node))
+      {
+         isGoal = true;
+         break;
+      }
+   }
+   goalStates.push_back(isGoal);
+   memoryUsed += cost;
+   return state;
+}
+
+//------------------------------------------------------------------------------
+// flushCache()
+// Drops every cached DFA node, including the start node, which isMatch()
+// re-adds on its next call.
+//------------------------------------------------------------------------------
+void LazyDfa::flushCache(void)
+{
+   stateSets.clear();
+   nextStates.clear();
+   goalStates.clear();
+   memoryUsed = 0;
+   startState = DEAD_STATE;
+   ++flushes;
+}
+
+//------------------------------------------------------------------------------
+// stepNodeSet(const NodeSet& srcSet, unsigned char inputChar, NodeSet& destSet)
+// Fills destSet with every node reachable from srcSet on inputChar.
+// stepMarks keeps nodes from being added twice without clearing anything
+// between steps.
+//------------------------------------------------------------------------------
+void LazyDfa::stepNodeSet(const NodeSet& srcSet, unsigned char inputChar,
+   NodeSet& destSet)
+{
+   destSet.clear();
+   if(++stepMark == 0)
+   {
+      fill(stepMarks.begin(), stepMarks.end(), 0);
+      stepMark = 1;
+   }
+   for(int source : srcSet)
+   {
+      TransitionIndex::NodeRange dests =
+         index.destinations(source, static_cast<char>(inputChar));
+      for(const int* dest = dests.first; dest != dests.second; ++dest)
+      {
+         if(stepMarks[*dest] != stepMark)
+         {
+            stepMarks[*dest] = stepMark;
+            destSet.push_back(*dest);
+         }
+      }
+   }
+   sort(destSet.begin(), destSet.end());
+}
+
+//------------------------------------------------------------------------------
+// matchNodeSets(NodeSet nodeSet, const char* input, size_t length)
+// Fallback for a thrashing cache: plain NFA simulation of input starting
+// from nodeSet, without caching anything.
+// Calls:
+//    stepNodeSet()
+//------------------------------------------------------------------------------
+bool LazyDfa::matchNodeSets(NodeSet nodeSet, const char* input, size_t length)
+{
+   NodeSet nextSet;
+   for(size_t pos = 0; pos < length; ++pos)
+   {
+      stepNodeSet(nodeSet, static_cast<unsigned char>(input[pos]), nextSet);
+      if(nextSet.empty())
+      {
+         return false;
+      }
+      nodeSet.swap(nextSet);
+   }
+   for(int node : nodeSet)
+   {
+      if(index.isGoal(node))
+      {
+         return true;
+      }
+   }
+   return false;
+}
@@ -0,0 +1,142 @@
+//------------------------------------------------------------------------------
+// LazyDfa.h
+// agent
+// 17 October 2026
+// Matches input strings based on a FiniteStateMachine in NFA format by
+// building DFA nodes on the fly, only when matching first reaches them.
+//------------------------------------------------------------------------------
+#ifndef LAZYDFA_H
+#define LAZYDFA_H
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "FiniteStateMachine.h"
+#include "CompactStateMachine.h"
+#include "TransitionIndex.h"
+#include "NodeSetTable.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// LazyDfa Class
+// Hybrid of CompiledNfaEpsilon and CompiledDfa.  Each DFA node stands for a
+// set of NFA nodes and owns a row of ALPHABET_SIZE cached
+// next nodes, which start out UNKNOWN_STATE and are filled in by a step of
+// NFA simulation the first time matching needs them.  The cache is bounded
+// by memoryBudget bytes; when a new node would exceed it, the whole cache is
+// flushed and rebuilt from the node being entered.  If one match flushes
+// more than MAX_FLUSHES_PER_MATCH times, the rest of that input is matched
+// by plain NFA simulation instead, since the cache is thrashing.
+// Matching fills the cache, so unlike CompiledDfa a LazyDfa must not be
+// shared between threads; give each thread its own.
+// No defaul constructor, instead can only be constructed with a
+// FiniteStateMachine or CompactStateMachine - should be formatted for
+// NFA-EPSILON but there is no validation that it is in NFA-EPSILON format.
+// Like CompiledNfaEpsilon it keeps the index of the machine with its epsilon
+// transitions eliminated, so filling in a transition takes no closure.
+// Public methods:
+//    checkString() x2
+//    cachedStateCount()
+//    flushCount()
+// Private methods:
+//    isMatch()
+//    computeNextState()
+//    addState()
+//    flushCache()
+//    stepNodeSet()
+//    matchNodeSets()
+// Members:
+//    index
+//    memoryBudget
+//    memoryUsed
+//    flushes
+//    startSet
+//    startState
+//    stateSets
+//    nextStates
+//    goalStates
+//    stepMarks
+//    stepScratch
+//------------------------------------------------------------------------------
+class LazyDfa
+{
+   public:
+      //Default cache budget in bytes
+      static constexpr size_t DEFAULT_MEMORY_BUDGET = 1 << 20;
+
+      //Constructor
+      LazyDfa(const FiniteStateMachine& nfae,
+         size_t budget = DEFAULT_MEMORY_BUDGET)
+         : LazyDfa(TransitionIndex(
+            TransitionIndex(nfae).eliminateEpsilons()), budget) {}
+
+      //Constructor from the contiguous representation
+      LazyDfa(const CompactStateMachine& nfae,
+         size_t budget = DEFAULT_MEMORY_BUDGET)
+         : LazyDfa(TransitionIndex(
+            TransitionIndex(nfae).eliminateEpsilons()), budget) {}
+
+      //Destructor - key word 'new' is not used.
+      ~LazyDfa(){}
+
+      //Returns value of isMatch()
+      inline bool checkString(string_view inputString)
+         {return isMatch(inputString.data(), inputString.size());}
+
+      //Returns value of isMatch() for a raw byte span
+      inline bool checkString(const char* input, size_t length)
+         {return isMatch(input, length);}
+
+      //Number of DFA nodes currently cached
+      inline size_t cachedStateCount(void) const {return stateSets.size();}
+
+      //Number of times the cache has been flushed
+      inline size_t flushCount(void) const {return flushes;}
+
+   private:
+      LazyDfa(); //no default constructor
+
+      //Constructor both public constructors delegate to
+      LazyDfa(TransitionIndex&& nfaeIndex, size_t budget);
+
+      static constexpr int ALPHABET_SIZE = 256;    //One column per byte value
+      static constexpr int UNKNOWN_STATE = -2;     //Not computed yet
+      static constexpr int DEAD_STATE = -1;        //Empty NFA node set
+      static constexpr int MAX_FLUSHES_PER_MATCH = 8;
+
+      TransitionIndex index;        //Index of the NFA without epsilons
+      size_t memoryBudget;          //Cache budget in bytes
+      size_t memoryUsed;            //Approximate bytes held by the cache
+      size_t flushes;               //Number of cache flushes so far
+      NodeSet startSet;             //Set of the start node
+      int startState;               //DFA node of startSet, if cached
+      //NFA node set of each DFA node; a set's id is its DFA node
+      NodeSetTable stateSets;
+      //Cached next DFA nodes, cachedStateCount() x ALPHABET_SIZE
+      vector<int> nextStates;
+      vector<char> goalStates;      //Goal flag per DFA node
+      vector<uint32_t> stepMarks;   //Per NFA node, last step that added it
+      uint32_t stepMark;            //Current step for stepMarks
+      NodeSet stepScratch;          //Destination set being built
+
+      //Returns true of input matches the NFA, false otherwise
+      bool isMatch(const char* input, size_t length);
+
+      //Fills in the cached next DFA node of state on inputChar
+      int computeNextState(int state, unsigned char inputChar);
+
+      //Caches nodeSet as a new DFA node, flushing first if over budget
+      int addState(const NodeSet& nodeSet);
+
+      //Drops every cached DFA node
+      void flushCache(void);
+
+      //Fills destSet with the epsilon-closed successors of srcSet
+      void stepNodeSet(const NodeSet& srcSet, unsigned char inputChar,
+         NodeSet& destSet);
+
+      //Matches the rest of input by NFA simulation from nodeSet
+      bool matchNodeSets(NodeSet nodeSet, const char* input, size_t length);
+};
+
+#endif // LAZYDFA_H
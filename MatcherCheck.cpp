@@ -0,0 +1,129 @@
+//------------------------------------------------------------------------------
+// MatcherCheck.cpp
+// agent
+// 17 October 2026
+// Check driver for matchers generated by DfaGen.
+// Compiled once per generated header, named by two macros:
+//    -DMATCHER_HEADER='"rules.h"' -DMATCHER_NAME=rules
+// and run on the DFA file the header was generated from:
+//    matchercheck rules.cdfa [--seed=N]
+// Every input of up to two bytes, then random inputs drawn mostly from the
+// bytes the DFA has live transitions on, are matched by both the generated
+// matcher and CompiledDfa::checkString().  Any input they disagree on is
+// printed and the exit status is 1.
+//------------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "CompiledDfa.h"
+
+#ifndef MATCHER_HEADER
+#error "compile with -DMATCHER_HEADER='\"name.h\"' -DMATCHER_NAME=name"
+#endif
+#include MATCHER_HEADER
+
+using namespace std;
+
+//Random inputs checked after the exhaustive ones
+static const int RANDOM_INPUTS = 200000;
+//Longest random input
+static const int MAX_RANDOM_LENGTH = 64;
+//Mismatches printed before giving up
+static const int MAX_REPORTED = 10;
+
+//------------------------------------------------------------------------------
+// liveBytes(const CompiledDfa& dfa)
+// Bytes that lead some state somewhere other than the dead state, so random
+// inputs get past the first few bytes.
+//------------------------------------------------------------------------------
+static vector<unsigned char> liveBytes(const CompiledDfa& dfa)
+{
+   vector<unsigned char> bytes;
+   for(int byte = 0; byte < 256; ++byte)
+   {
+      for(int state = 0; state < dfa.size(); ++state)
+      {
+         if(!dfa.isDeadState(dfa.nextState(state, byte)))
+         {
+            bytes.push_back(static_cast<unsigned char>(byte));
+            break;
+         }
+      }
+   }
+   return bytes;
+}
+
+int main(int argc, char* argv[])
+{
+   unsigned seed = 1;
+   if(argc == 3 && strncmp(argv[2], "--seed=", 7) == 0)
+   {
+      seed = static_cast<unsigned>(strtoul(argv[2] + 7, nullptr, 10));
+   }
+   else if(argc != 2)
+   {
+      fprintf(stderr, "usage: %s input.cdfa [--seed=N]\n", argv[0]);
+      return 1;
+   }
+   unique_ptr<CompiledDfa> dfa = CompiledDfa::load(argv[1]);
+   if(!dfa)
+   {
+      fprintf(stderr, "%s: %s is not a valid DFA file\n", argv[0], argv[1]);
+      return 1;
+   }
+
+   size_t checked = 0;
+   int mismatches = 0;
+   auto check = [&](const string& input)
+   {
+      ++checked;
+      bool expected = dfa->checkString(input);
+      if(MATCHER_NAME::checkString(input) == expected)
+      {
+         return;
+      }
+      if(++mismatches <= MAX_REPORTED)
+      {
+         fprintf(stderr, "mismatch on \"");
+         for(unsigned char c : input)
+         {
+            fprintf(stderr, "\\x%02x", c);
+         }
+         fprintf(stderr, "\": CompiledDfa %s\n", expected ? "true" : "false");
+      }
+   };
+
+   check("");
+   for(int first = 0; first < 256; ++first)
+   {
+      check(string(1, static_cast<char>(first)));
+      for(int second = 0; second < 256; ++second)
+      {
+         check(string{static_cast<char>(first), static_cast<char>(second)});
+      }
+   }
+
+   vector<unsigned char> bytes = liveBytes(*dfa);
+   mt19937 random(seed);
+   uniform_int_distribution<int> length(0, MAX_RANDOM_LENGTH);
+   uniform_int_distribution<int> anyByte(0, 255);
+   uniform_int_distribution<int> percent(0, 99);
+   for(int count = 0; count < RANDOM_INPUTS; ++count)
+   {
+      string input(length(random), '\0');
+      for(char& c : input)
+      {
+         //One byte in a hundred is arbitrary, to leave the live bytes
+         bool live = !bytes.empty() && percent(random) != 0;
+         c = static_cast<char>(live ?
+            bytes[random() % bytes.size()] : anyByte(random));
+      }
+      check(input);
+   }
+
+   printf("{\"checked\": %zu, \"mismatches\": %d}\n", checked, mismatches);
+   return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+//------------------------------------------------------------------------------
+// NodeSetTable.cpp
+// agent
+// 17 October 2026
+// Implementation for NodeSetTable.h
+// Contains implementation for:
+//    NodeSetHash::operator()
+//    sortNodeSet()
+//    intern()
+//------------------------------------------------------------------------------
+#include "NodeSetTable.h"
+#include <algorithm>
+#include <cstdint>
+
+//------------------------------------------------------------------------------
+// NodeSetHash::operator()(const NodeSet& nodeSet)
+// Mixes every node of nodeSet into a 64 bit FNV-1a style hash.
+//------------------------------------------------------------------------------
+size_t NodeSetHash::operator()(const NodeSet& nodeSet) const
+{
+   uint64_t hash = 14695981039346656037ULL;
+   for(int node : nodeSet)
+   {
+      hash ^= static_cast<uint32_t>(node);
+      hash *= 1099511628211ULL;
+   }
+   return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+//------------------------------------------------------------------------------
+// sortNodeSet(NodeSet& nodeSet)
+// Sorts nodeSet and drops duplicates, so that equal sets compare equal.
+// The NFAs are epsilon-free, so no closure is taken.
+//------------------------------------------------------------------------------
+void sortNodeSet(NodeSet& nodeSet)
+{
+   sort(nodeSet.begin(), nodeSet.end());
+   nodeSet.erase(unique(nodeSet.begin(), nodeSet.end()), nodeSet.end());
+}
+
+//------------------------------------------------------------------------------
+// intern(const NodeSet& nodeSet)
+// Looks nodeSet up, copying it into the table under the next id the first
+// time it is seen.
+//------------------------------------------------------------------------------
+pair<int, bool> NodeSetTable::intern(const NodeSet& nodeSet)
+{
+   auto found = ids.emplace(nodeSet, static_cast<int>(sets.size()));
+   if(found.second)
+   {
+      sets.push_back(&found.first->first);
+   }
+   return make_pair(found.first->second, found.second);
+}
@@ -0,0 +1,79 @@
+//------------------------------------------------------------------------------
+// NodeSetTable.h
+// agent
+// 17 October 2026
+// Interning of NFA node sets for the subset constructions
+//------------------------------------------------------------------------------
+#ifndef NODESETTABLE_H
+#define NODESETTABLE_H
+#include <unordered_map>
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// NodeSet
+// A set of NFA nodes as dense TransitionIndex numbers, sorted ascending with
+// no duplicates, so that equal sets always compare equal.  sortNodeSet()
+// puts a list of nodes in that form.  NodeSetHash lets NodeSets key
+// unordered maps.
+//------------------------------------------------------------------------------
+typedef vector<int> NodeSet;
+
+struct NodeSetHash
+{
+   size_t operator()(const NodeSet& nodeSet) const;
+};
+
+//Sorts nodeSet and drops duplicates, so that equal sets compare equal
+void sortNodeSet(NodeSet& nodeSet);
+
+//------------------------------------------------------------------------------
+// NodeSetTable Class
+// Gives every distinct NodeSet a dense id, in the order the sets are first
+// seen, and keeps one copy of each set.  CompiledNfaEpsilon, LazyDfa and
+// PatternSet all number the nodes of the DFA they build this way.  Ids are
+// only ever cleared all at once, so a set's id is stable until clear().
+// Public methods:
+//    intern()
+//    find()
+//    nodeSet()
+//    size()
+//    empty()
+//    clear()
+// Members:
+//    ids
+//    sets
+//------------------------------------------------------------------------------
+class NodeSetTable
+{
+   public:
+      //Returns the id of nodeSet and whether nodeSet was new; a new set
+      //gets id size()
+      pair<int, bool> intern(const NodeSet& nodeSet);
+
+      //Returns the id of nodeSet, -1 if it was never interned
+      inline int find(const NodeSet& nodeSet) const
+         {auto found = ids.find(nodeSet);
+          return found == ids.end() ? -1 : found->second;}
+
+      //Returns the set with id id
+      inline const NodeSet& nodeSet(int id) const {return *sets[id];}
+
+      //Number of interned sets
+      inline size_t size(void) const {return sets.size();}
+
+      inline bool empty(void) const {return sets.empty();}
+
+      //Forgets every set
+      inline void clear(void) {ids.clear(); sets.clear();}
+
+   private:
+      //Id of every interned set
+      unordered_map<NodeSet, int, NodeSetHash> ids;
+      //Key of each id in ids; map keys never move
+      vector<const NodeSet*> sets;
+};
+
+#endif // NODESETTABLE_H
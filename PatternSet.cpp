@@ -0,0 +1,211 @@
+//------------------------------------------------------------------------------
+// PatternSet.cpp
+// agent
+// 17 October 2026
+// Implementation for PatternSet.h
+// Contains implementation for:
+//    Constructor x2
+//    compile()
+//    matchingRules()
+//    buildUnion()
+//    determinize()
+//------------------------------------------------------------------------------
+#include "PatternSet.h"
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+// Constructs a PatternSet from ruleList.  Rule ids are positions in ruleList.
+// Each rule is indexed with its epsilon transitions eliminated.
+// Calls:
+//    compile()
+//------------------------------------------------------------------------------
+PatternSet::PatternSet(const vector<FiniteStateMachine>& ruleList)
+: rules(static_cast<int>(ruleList.size())), start(DEAD_STATE)
+{
+   vector<TransitionIndex> ruleIndexes;
+   ruleIndexes.reserve(ruleList.size());
+   for(const FiniteStateMachine& rule : ruleList)
+   {
+      ruleIndexes.emplace_back(TransitionIndex(rule).eliminateEpsilons());
+   }
+   compile(ruleIndexes);
+}
+
+//------------------------------------------------------------------------------
+// Constructs a PatternSet from a list of CompactStateMachines, exactly as the
+// FiniteStateMachine constructor does.
+// Calls:
+//    compile()
+//------------------------------------------------------------------------------
+PatternSet::PatternSet(const vector<CompactStateMachine>& ruleList)
+: rules(static_cast<int>(ruleList.size())), start(DEAD_STATE)
+{
+   vector<TransitionIndex> ruleIndexes;
+   ruleIndexes.reserve(ruleList.size());
+   for(const CompactStateMachine& rule : ruleList)
+   {
+      ruleIndexes.emplace_back(TransitionIndex(rule).eliminateEpsilons());
+   }
+   compile(ruleIndexes);
+}
+
+//------------------------------------------------------------------------------
+// compile(const vector<TransitionIndex>& ruleIndexes)
+// Joins the rules into one NFA, indexes it and determinizes it.
+// Calls:
+//    buildUnion()
+//    determinize()
+//------------------------------------------------------------------------------
+void PatternSet::compile(const vector<TransitionIndex>& ruleIndexes)
+{
+   vector<int> ruleOfNode;
+   NodeSet startSet;
+   TransitionIndex unionIndex(buildUnion(ruleIndexes, ruleOfNode, startSet));
+   determinize(unionIndex, ruleOfNode, startSet);
+}
+
+//------------------------------------------------------------------------------
+// matchingRules(const char* input, size_t length, vector<int>& matched)
+// One pass over input through the transition table, then copies the rule
+// list of the final DFA node into matched.  Stops early once DEAD_STATE is
+// reached, which accepts no rule.
+//------------------------------------------------------------------------------
+void PatternSet::matchingRules(const char* input, size_t length,
+   vector<int>& matched) const
+{
+   matched.clear();
+   int curState = start;
+   for(size_t pos = 0; pos < length; ++pos)
+   {
+      curState = transitionTable[curState * ALPHABET_SIZE +
+         static_cast<unsigned char>(input[pos])];
+      if(curState == DEAD_STATE)
+      {
+         return;
+      }
+   }
+   matched.assign(acceptedRules.begin() + ruleOffsets[curState],
+      acceptedRules.begin() + ruleOffsets[curState + 1]);
+}
+
+//------------------------------------------------------------------------------
+// buildUnion(const vector<TransitionIndex>& ruleIndexes,
+// vector<int>& ruleOfNode, NodeSet& startSet)
+// Renumbers the nodes of every rule into one range, rule by rule, records in
+// ruleOfNode which rule each goal node belongs to (-1 for other nodes) and
+// puts every rule start node in startSet.  A start node joined to the rule
+// start nodes by epsilon transitions would only stand for startSet, so the
+// union has none and its startNode() is not used.
+//------------------------------------------------------------------------------
+CompactStateMachine PatternSet::buildUnion(
+   const vector<TransitionIndex>& ruleIndexes, vector<int>& ruleOfNode,
+   NodeSet& startSet)
+{
+   int nodeTotal = 0;
+   size_t transitionTotal = 0;
+   for(const TransitionIndex& ruleIndex : ruleIndexes)
+   {
+      nodeTotal += ruleIndex.size();
+      transitionTotal += ruleIndex.edgesEnd(ruleIndex.size() - 1);
+   }
+   CompactStateMachine unionNfa;
+   unionNfa.reserve(nodeTotal, transitionTotal);
+   ruleOfNode.clear();
+   startSet.clear();
+   int offset = 0;
+   for(int rule = 0; rule < rules; ++rule)
+   {
+      const TransitionIndex& ruleIndex = ruleIndexes[rule];
+      for(int node = 0; node < ruleIndex.size(); ++node)
+      {
+         unionNfa.addNode();
+         ruleOfNode.push_back(ruleIndex.isGoal(node) ? rule : -1);
+         for(int edge = ruleIndex.edgesBegin(node);
+            edge < ruleIndex.edgesEnd(node); ++edge)
+         {
+            unionNfa.addTransition(offset + node, ruleIndex.edgeSymbol(edge),
+               offset + ruleIndex.edgeDestination(edge));
+         }
+      }
+      startSet.push_back(offset + ruleIndex.startNode());
+      offset += ruleIndex.size();
+   }
+   return unionNfa;
+}
+
+//------------------------------------------------------------------------------
+// determinize(const TransitionIndex& unionIndex, const vector<int>& ruleOfNode,
+// NodeSet& startSet)
+// Breadth first subset construction over the union NFA from startSet.  Each
+// NodeSet reached is interned in dfaSets, and its id plus one is its DFA node,
+// leaving 0 to DEAD_STATE.  The edges leaving a set are gathered and sorted by
+// char, so only chars actually used are visited, and the destinations of
+// each char are already a complete set.  Each new DFA node gets the sorted,
+// duplicate-free list of rules owning a goal node in its set.
+//------------------------------------------------------------------------------
+void PatternSet::determinize(const TransitionIndex& unionIndex,
+   const vector<int>& ruleOfNode, NodeSet& startSet)
+{
+   NodeSetTable dfaSets;
+   ruleOffsets.assign(1, 0);
+   transitionTable.assign(ALPHABET_SIZE, DEAD_STATE);
+   ruleOffsets.push_back(0);
+
+   auto addState = [&](const NodeSet& nodeSet)
+   {
+      pair<int, bool> found = dfaSets.intern(nodeSet);
+      if(!found.second)
+      {
+         return found.first + 1;
+      }
+      size_t firstRule = acceptedRules.size();
+      for(int node : nodeSet)
+      {
+         int rule = ruleOfNode[unionIndex.nodeOf(node)];
+         if(rule >= 0)
+         {
+            acceptedRules.push_back(rule);
+         }
+      }
+      sort(acceptedRules.begin() + firstRule, acceptedRules.end());
+      acceptedRules.erase(unique(acceptedRules.begin() + firstRule,
+         acceptedRules.end()), acceptedRules.end());
+      ruleOffsets.push_back(static_cast<int>(acceptedRules.size()));
+      transitionTable.resize(transitionTable.size() + ALPHABET_SIZE,
+         DEAD_STATE);
+      return found.first + 1;
+   };
+
+   start = addState(startSet);
+
+   vector<pair<unsigned char, int>> edges;
+   NodeSet destSet;
+   for(size_t next = 0; next < dfaSets.size(); ++next)
+   {
+      int state = static_cast<int>(next) + 1;
+      edges.clear();
+      for(int node : dfaSets.nodeSet(static_cast<int>(next)))
+      {
+         for(int edge = unionIndex.edgesBegin(node);
+            edge < unionIndex.edgesEnd(node); ++edge)
+         {
+            edges.emplace_back(
+               static_cast<unsigned char>(unionIndex.edgeSymbol(edge)),
+               unionIndex.edgeDestination(edge));
+         }
+      }
+      sort(edges.begin(), edges.end());
+      edges.erase(unique(edges.begin(), edges.end()), edges.end());
+      for(size_t first = 0; first < edges.size(); )
+      {
+         unsigned char byte = edges[first].first;
+         destSet.clear();
+         for(; first < edges.size() && edges[first].first == byte; ++first)
+         {
+            destSet.push_back(edges[first].second);
+         }
+         int dest = addState(destSet);
+         transitionTable[state * ALPHABET_SIZE + byte] = dest;
+      }
+   }
+}
@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------
+// PatternSet.h
+// agent
+// 17 October 2026
+// Matches input strings against many FiniteStateMachines in a single pass
+// and reports which of them matched.
+//------------------------------------------------------------------------------
+#ifndef PATTERNSET_H
+#define PATTERNSET_H
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "FiniteStateMachine.h"
+#include "CompactStateMachine.h"
+#include "TransitionIndex.h"
+#include "NodeSetTable.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// PatternSet Class
+// Compiles a list of rules, each a FiniteStateMachine or CompactStateMachine
+// in DFA or NFA-EPSILON format, into one DFA.  The epsilon transitions of
+// every rule are eliminated, then the rules are joined into a single NFA
+// whose start set is the start node of every rule, which is determinized
+// without taking any epsilon closure.  Every DFA node keeps the sorted list
+// of rule ids (positions in the list passed to the constructor) that accept
+// there, so one pass over the input yields every matching rule.
+// The DFA is stored like CompiledDfa: a flat stateCount x ALPHABET_SIZE
+// table of next nodes with row DEAD_STATE standing in for every missing
+// transition.
+// No defaul constructor, instead can only be constructed with a list of
+// FiniteStateMachines or CompactStateMachines.
+// Public methods:
+//    matchingRules() x2
+//    ruleCount()
+//    stateCount()
+// Private methods:
+//    compile()
+//    buildUnion()
+//    determinize()
+// Members:
+//    rules
+//    start
+//    transitionTable
+//    ruleOffsets
+//    acceptedRules
+//------------------------------------------------------------------------------
+class PatternSet
+{
+   public:
+      //Constructor
+      PatternSet(const vector<FiniteStateMachine>& ruleList);
+
+      //Constructor from the contiguous representation
+      PatternSet(const vector<CompactStateMachine>& ruleList);
+
+      //Destructor - key word 'new' is not used.
+      ~PatternSet(){}
+
+      //Returns the ids of every rule matching inputString, ascending
+      inline vector<int> matchingRules(string_view inputString) const
+         {vector<int> matched;
+          matchingRules(inputString.data(), inputString.size(), matched);
+          return matched;}
+
+      //Fills matched with the ids of every rule matching input, ascending
+      void matchingRules(const char* input, size_t length,
+         vector<int>& matched) const;
+
+      //Number of rules passed to the constructor
+      inline int ruleCount(void) const {return rules;}
+
+      //Number of DFA nodes, including DEAD_STATE
+      inline int stateCount(void) const
+         {return static_cast<int>(ruleOffsets.size()) - 1;}
+
+   private:
+      PatternSet(); //no default constructor
+
+      static constexpr int DEAD_STATE = 0;       //Dense index of the sink
+      static constexpr int ALPHABET_SIZE = 256;  //One column per byte value
+
+      int rules;                    //Number of rules
+      int start;                    //DFA node of the rule start nodes
+      //Flat table of next DFA nodes, row-major by node
+      vector<int> transitionTable;
+      //acceptedRules[ruleOffsets[s] .. ruleOffsets[s + 1] - 1] are the rule
+      //ids accepting at DFA node s
+      vector<int> ruleOffsets;
+      vector<int> acceptedRules;
+
+      //Builds the DFA from the epsilon-free transition index of every rule
+      void compile(const vector<TransitionIndex>& ruleIndexes);
+
+      //Joins the rules into one NFA, filling ruleOfNode for its goal nodes
+      //and startSet with the rule start nodes
+      CompactStateMachine buildUnion(
+         const vector<TransitionIndex>& ruleIndexes, vector<int>& ruleOfNode,
+         NodeSet& startSet);
+
+      //Subset construction of the union NFA from startSet
+      void determinize(const TransitionIndex& unionIndex,
+         const vector<int>& ruleOfNode, NodeSet& startSet);
+};
+
+#endif // PATTERNSET_H
@@ -0,0 +1,172 @@
+//------------------------------------------------------------------------------
+// Prefilter.cpp
+// agent
+// 17 October 2026
+// Implementation for Prefilter.h
+// Contains Implementations for:
+//    Constructor
+//    skipForward()
+//    skipBackward()
+//    literalPrefix()
+//    findLiteral()
+//    findLastByte()
+//------------------------------------------------------------------------------
+#include "Prefilter.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+
+//------------------------------------------------------------------------------
+// Constructs a Prefilter for state of dfa by reading its table row.  The
+// filter is disabled (escapeCount 0) if state is a goal state or has too
+// many escape bytes to be worth skipping to.  A prefix shorter than two
+// bytes gains nothing over the escape bytes and is dropped.
+//------------------------------------------------------------------------------
+Prefilter::Prefilter(const CompiledDfa& dfa, int state, const string& prefix)
+   : escapeCount(0), escapeByte(0), literal(prefix.size() > 1 ? prefix : "")
+{
+   for(int byte = 0; byte < ALPHABET_SIZE; ++byte)
+   {
+      escapes[byte] = dfa.nextState(state, static_cast<unsigned char>(byte))
+         != state;
+      if(escapes[byte])
+      {
+         escapeByte = static_cast<unsigned char>(byte);
+         ++escapeCount;
+      }
+   }
+   if(dfa.isGoalState(state) || escapeCount > MAX_ESCAPE_BYTES)
+   {
+      escapeCount = 0;
+      literal.clear();
+   }
+}
+
+//------------------------------------------------------------------------------
+// skipForward(const char* input, size_t pos, size_t length)
+// Returns the first position q >= pos where the state may be left: the
+// start of the next occurrence of the literal, or the next escape byte.
+// Returns length if there is none and pos itself if the filter is disabled.
+//------------------------------------------------------------------------------
+size_t Prefilter::skipForward(const char* input, size_t pos,
+   size_t length) const
+{
+   if(escapeCount == 0)
+   {
+      return pos;
+   }
+   if(!literal.empty())
+   {
+      return findLiteral(input, pos, length);
+   }
+   if(escapeCount == 1)
+   {
+      const void* found = memchr(input + pos, escapeByte, length - pos);
+      return found ? static_cast<const char*>(found) - input : length;
+   }
+   while(pos < length && !escapes[static_cast<unsigned char>(input[pos])])
+   {
+      ++pos;
+   }
+   return pos;
+}
+
+//------------------------------------------------------------------------------
+// skipBackward(const char* input, size_t from, size_t end)
+// Mirror image of skipForward() for a scan reading input[end - 1] down to
+// input[from]: returns the largest e <= end such that input[e - 1] may
+// leave the state, or from if there is none.  The literal is not used.
+//------------------------------------------------------------------------------
+size_t Prefilter::skipBackward(const char* input, size_t from,
+   size_t end) const
+{
+   if(escapeCount == 0)
+   {
+      return end;
+   }
+   if(escapeCount == 1)
+   {
+      return findLastByte(input, from, end);
+   }
+   while(end > from && !escapes[static_cast<unsigned char>(input[end - 1])])
+   {
+      --end;
+   }
+   return end;
+}
+
+//------------------------------------------------------------------------------
+// literalPrefix(const CompiledDfa& dfa)
+// Follows dfa from its start state for as long as the current state is not
+// a goal state and exactly one byte leads anywhere but the dead state.  The
+// bytes followed are the literal every accepted input begins with.  The
+// literal is capped at ALPHABET_SIZE bytes, so a cycle of single bytes that
+// never reaches a goal state cannot loop forever.
+//------------------------------------------------------------------------------
+string Prefilter::literalPrefix(const CompiledDfa& dfa)
+{
+   string prefix;
+   int state = dfa.startState();
+   while(!dfa.isGoalState(state) && prefix.size() < ALPHABET_SIZE)
+   {
+      int onlyNext = -1;
+      unsigned char onlyByte = 0;
+      for(int byte = 0; byte < ALPHABET_SIZE && onlyNext != -2; ++byte)
+      {
+         int next = dfa.nextState(state, static_cast<unsigned char>(byte));
+         if(!dfa.isDeadState(next))
+         {
+            onlyNext = (onlyNext == -1) ? next : -2;
+            onlyByte = static_cast<unsigned char>(byte);
+         }
+      }
+      if(onlyNext < 0)
+      {
+         break;
+      }
+      prefix.push_back(static_cast<char>(onlyByte));
+      state = onlyNext;
+   }
+   return prefix;
+}
+
+//------------------------------------------------------------------------------
+// findLiteral(const char* input, size_t pos, size_t length)
+// Returns the start of the first occurrence of literal in input[pos] ..
+// input[length - 1], or length.  memmem() is a GNU extension, so other C
+// libraries get the standard Boyer-Moore-Horspool searcher instead.
+//------------------------------------------------------------------------------
+size_t Prefilter::findLiteral(const char* input, size_t pos,
+   size_t length) const
+{
+#ifdef __GLIBC__
+   const void* found = memmem(input + pos, length - pos, literal.data(),
+      literal.size());
+   return found ? static_cast<const char*>(found) - input : length;
+#else
+   const char* found = search(input + pos, input + length,
+      boyer_moore_horspool_searcher<string::const_iterator>(literal.begin(),
+         literal.end()));
+   return found - input;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// findLastByte(const char* input, size_t from, size_t end)
+// Returns one past the last escapeByte in input[from] .. input[end - 1], or
+// from.  memrchr() is a GNU extension, so other C libraries scan backwards
+// with find() over reverse iterators instead.
+//------------------------------------------------------------------------------
+size_t Prefilter::findLastByte(const char* input, size_t from,
+   size_t end) const
+{
+#ifdef __GLIBC__
+   const void* found = memrchr(input + from, escapeByte, end - from);
+   return found ? static_cast<const char*>(found) - input + 1 : from;
+#else
+   reverse_iterator<const char*> last(input + end);
+   reverse_iterator<const char*> first(input + from);
+   return find(last, first, static_cast<char>(escapeByte)).base() - input;
+#endif
+}
@@ -0,0 +1,83 @@
+//------------------------------------------------------------------------------
+// Prefilter.h
+// agent
+// 17 October 2026
+// Skips the parts of an input that cannot move a CompiledDfa out of a given
+// state.
+//------------------------------------------------------------------------------
+#ifndef PREFILTER_H
+#define PREFILTER_H
+#include <cstddef>
+#include <string>
+#include "CompiledDfa.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// Prefilter Class
+// Built from a CompiledDfa state that loops to itself on most bytes, such as
+// the start state of Searcher's unanchored machines.  The bytes that leave
+// the state (its escape bytes) are collected once; a scan sitting in that
+// state can then jump straight to the next escape byte instead of reading
+// every byte through the transition table:
+//    one escape byte         - memchr() forwards, memrchr() backwards
+//    up to MAX_ESCAPE_BYTES  - a loop over a 256 entry byte-set table
+//    more                    - no skipping, the table loop would not gain
+// A literal that every match has to begin with can be supplied as well; a
+// forward skip of two or more literal bytes uses memmem().  literalPrefix()
+// finds that literal in an anchored CompiledDfa.  memmem() and memrchr() are
+// GNU extensions; other C libraries get the standard library equivalents.
+// A state that is a goal state is never skipped over, since every position
+// it is in would have to be reported.
+// Public methods:
+//    skipForward()
+//    skipBackward()
+//    literalPrefix()
+// Private methods:
+//    findLiteral()
+//    findLastByte()
+// Members:
+//    escapes
+//    escapeCount
+//    escapeByte
+//    literal
+//------------------------------------------------------------------------------
+class Prefilter
+{
+   public:
+      //Constructor
+      Prefilter(const CompiledDfa& dfa, int state,
+         const string& prefix = string());
+
+      //Destructor - key word 'new' is not used.
+      ~Prefilter(){}
+
+      //Returns the first position at or after pos that may leave the state
+      size_t skipForward(const char* input, size_t pos, size_t length) const;
+
+      //Returns the last end at or before end whose byte may leave the state
+      size_t skipBackward(const char* input, size_t from, size_t end) const;
+
+      //Returns the literal every input accepted by dfa begins with
+      static string literalPrefix(const CompiledDfa& dfa);
+
+   private:
+      Prefilter(); //no default constructor
+
+      //Start of the first literal at or after pos, or length
+      size_t findLiteral(const char* input, size_t pos, size_t length) const;
+
+      //One past the last escapeByte between from and end, or from
+      size_t findLastByte(const char* input, size_t from, size_t end) const;
+
+      static constexpr int ALPHABET_SIZE = 256;  //One entry per byte value
+      //Most escape bytes worth skipping to with the byte-set table
+      static constexpr int MAX_ESCAPE_BYTES = 16;
+
+      bool escapes[ALPHABET_SIZE];  //Bytes that leave the state
+      int escapeCount;              //Number of escape bytes, 0 if disabled
+      unsigned char escapeByte;     //The escape byte if there is only one
+      string literal;               //Literal every match begins with
+};
+
+#endif // PREFILTER_H
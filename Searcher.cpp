@@ -0,0 +1,368 @@
+//------------------------------------------------------------------------------
+// Searcher.cpp
+// agent
+// 17 October 2026
+// Implementation for Searcher.h
+// Contains Implementations for:
+//    Constructor
+//    find()
+//    findAll()
+//    Cursor::Constructor
+//    Cursor::next()
+//    machineOf()
+//    buildForward()
+//    buildReverse()
+//    determinize()
+//    lastMatchEnd()
+//    scanStarts()
+//    longestMatchEnd()
+//------------------------------------------------------------------------------
+#include "Searcher.h"
+
+//------------------------------------------------------------------------------
+// Constructs a Searcher for fsm, in DFA or NFA-EPSILON format, then the
+// prefilters of the two unanchored machines.  The unanchored machines are
+// built from fsm with its epsilon transitions eliminated, so that every
+// transition of fsm is an edge of the index they are copied from.
+// Calls:
+//    buildForward()
+//    buildReverse()
+//    determinize()
+//------------------------------------------------------------------------------
+Searcher::Searcher(const CompactStateMachine& fsm)
+   : forward(determinize(buildForward(
+        TransitionIndex(TransitionIndex(fsm).eliminateEpsilons()))), true),
+     reverse(determinize(buildReverse(
+        TransitionIndex(TransitionIndex(fsm).eliminateEpsilons()))), true),
+     anchored(determinize(fsm), true),
+     forwardFilter(forward, forward.startState(),
+        Prefilter::literalPrefix(anchored)),
+     reverseFilter(reverse, reverse.startState())
+{
+}
+
+//------------------------------------------------------------------------------
+// find(const char* input, size_t length, size_t from, Match& match)
+// The forward scan from from finds the last match end; none means no
+// match.  The backward scan from there keeps the lowest start it passes,
+// which is the leftmost match start, and the anchored machine extends it
+// to the longest match.
+// Calls:
+//    lastMatchEnd()
+//    scanStarts()
+//    longestMatchEnd()
+//------------------------------------------------------------------------------
+bool Searcher::find(const char* input, size_t length, size_t from,
+   Match& match) const
+{
+   if(from > length)
+   {
+      return false;
+   }
+   size_t lastEnd = lastMatchEnd(input, from, length);
+   if(lastEnd == string_view::npos)
+   {
+      return false;
+   }
+   size_t leftmost = lastEnd;
+   scanStarts(input, from, lastEnd, [&leftmost](size_t pos)
+      {leftmost = pos;});
+   match.start = leftmost;
+   match.end = longestMatchEnd(input, leftmost, lastEnd);
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// findAll(const char* input, size_t length, vector<Match>& matches)
+// Collects every match of a Cursor over the whole input.
+// Calls:
+//    Cursor::next()
+//------------------------------------------------------------------------------
+void Searcher::findAll(const char* input, size_t length,
+   vector<Match>& matches) const
+{
+   matches.clear();
+   Cursor cursor(*this, input, length);
+   Match match;
+   while(cursor.next(match))
+   {
+      matches.push_back(match);
+   }
+}
+
+//------------------------------------------------------------------------------
+// Cursor(const Searcher& owner, const char* inputChars, size_t length,
+// size_t fromPos)
+// Like find(), but the backward scan records every match start in a bitmap
+// so that each following match only needs the anchored machine.  A match
+// start depends only on the input from that position on, so starts stay
+// valid however the earlier matches fell.
+// Calls:
+//    lastMatchEnd()
+//    scanStarts()
+//------------------------------------------------------------------------------
+Searcher::Cursor::Cursor(const Searcher& owner, const char* inputChars,
+   size_t length, size_t fromPos)
+: searcher(owner), input(inputChars), from(fromPos),
+  lastEnd(string_view::npos), pos(fromPos)
+{
+   if(from > length)
+   {
+      return;
+   }
+   lastEnd = searcher.lastMatchEnd(input, from, length);
+   if(lastEnd == string_view::npos)
+   {
+      return;
+   }
+   starts.assign(((lastEnd - from) >> 6) + 1, 0);
+   searcher.scanStarts(input, from, lastEnd, [this](size_t start)
+      {size_t bit = start - from;
+       starts[bit >> 6] |= uint64_t(1) << (bit & 63);});
+}
+
+//------------------------------------------------------------------------------
+// next(Match& match)
+// Takes the first recorded start at or after pos and extends it with the
+// anchored machine.  After an empty match the next search begins one byte
+// later.
+// Calls:
+//    longestMatchEnd()
+//------------------------------------------------------------------------------
+bool Searcher::Cursor::next(Match& match)
+{
+   if(lastEnd == string_view::npos || pos > lastEnd)
+   {
+      return false;
+   }
+   size_t word = (pos - from) >> 6;
+   uint64_t bits = starts[word] & (~uint64_t(0) << ((pos - from) & 63));
+   while(bits == 0 && ++word < starts.size())
+   {
+      bits = starts[word];
+   }
+   if(bits == 0)
+   {
+      pos = lastEnd + 1;
+      return false;
+   }
+   match.start = from + ((word << 6) | __builtin_ctzll(bits));
+   match.end = searcher.longestMatchEnd(input, match.start, lastEnd);
+   pos = (match.end > match.start) ? match.end : match.start + 1;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// machineOf(const CompiledDfa& dfa)
+// Copies the dense states of dfa, one transition per byte that does not
+// lead to the dead state.
+//------------------------------------------------------------------------------
+CompactStateMachine Searcher::machineOf(const CompiledDfa& dfa)
+{
+   CompactStateMachine machine;
+   for(int state = 0; state < dfa.size(); ++state)
+   {
+      machine.addNode();
+      if(dfa.isGoalState(state))
+      {
+         machine.setGoal(state);
+      }
+      for(int byte = 0; byte < 256; ++byte)
+      {
+         int dest = dfa.nextState(state, static_cast<unsigned char>(byte));
+         if(!dfa.isDeadState(dest))
+         {
+            machine.addTransition(state, static_cast<char>(byte), dest);
+         }
+      }
+   }
+   machine.setStartNode(dfa.startState());
+   return machine;
+}
+
+//------------------------------------------------------------------------------
+// buildForward(const TransitionIndex& index)
+// Copies the indexed machine in dense numbering and adds a new start node,
+// index.size(), that loops to itself on every byte and has an EPSILON
+// transition to the old start node.
+//------------------------------------------------------------------------------
+CompactStateMachine Searcher::buildForward(const TransitionIndex& index)
+{
+   CompactStateMachine unanchored;
+   int loopNode = index.size();
+   unanchored.reserve(loopNode + 1, index.edgesEnd(loopNode - 1) + 256, 1);
+   for(int node = 0; node < index.size(); ++node)
+   {
+      unanchored.addNode();
+      if(index.isGoal(node))
+      {
+         unanchored.setGoal(node);
+      }
+      for(int edge = index.edgesBegin(node); edge < index.edgesEnd(node);
+         ++edge)
+      {
+         unanchored.addTransition(node, index.edgeSymbol(edge),
+            index.edgeDestination(edge));
+      }
+   }
+   unanchored.setStartNode(unanchored.addNode());
+   for(int byte = 0; byte < 256; ++byte)
+   {
+      unanchored.addTransition(loopNode, static_cast<char>(byte), loopNode);
+   }
+   unanchored.addTransition(loopNode, EPSILON, index.startNode());
+   return unanchored;
+}
+
+//------------------------------------------------------------------------------
+// buildReverse(const TransitionIndex& index)
+// Copies the indexed machine in dense numbering with every transition
+// pointing the other way.  The old start node is the only goal node.  A new
+// start node, index.size(), loops to itself on every byte and has an
+// EPSILON transition to every old goal node.
+//------------------------------------------------------------------------------
+CompactStateMachine Searcher::buildReverse(const TransitionIndex& index)
+{
+   CompactStateMachine reversed;
+   int loopNode = index.size();
+   reversed.reserve(loopNode + 1, index.edgesEnd(loopNode - 1) + 256,
+      loopNode);
+   for(int node = 0; node < index.size(); ++node)
+   {
+      reversed.addNode();
+      if(index.isGoal(node))
+      {
+         reversed.addTransition(loopNode, EPSILON, node);
+      }
+      for(int edge = index.edgesBegin(node); edge < index.edgesEnd(node);
+         ++edge)
+      {
+         reversed.addTransition(index.edgeDestination(edge),
+            index.edgeSymbol(edge), node);
+      }
+   }
+   reversed.setStartNode(reversed.addNode());
+   reversed.setGoal(index.startNode());
+   for(int byte = 0; byte < 256; ++byte)
+   {
+      reversed.addTransition(loopNode, static_cast<char>(byte), loopNode);
+   }
+   return reversed;
+}
+
+//------------------------------------------------------------------------------
+// determinize(const CompactStateMachine& nfae)
+// Subset construction by CompiledNfaEpsilon.  NODE_SET mode skips building
+// the bit parallel tables, which are never used here.
+//------------------------------------------------------------------------------
+CompactStateMachine Searcher::determinize(const CompactStateMachine& nfae)
+{
+   return CompiledNfaEpsilon(nfae, CompiledNfaEpsilon::NODE_SET)
+      .translateToCompactDFA();
+}
+
+//------------------------------------------------------------------------------
+// lastMatchEnd(const char* input, size_t from, size_t length)
+// Runs the forward machine over input from from to length.  It is in a goal
+// state exactly where some match that starts at or after from ends.
+// Whenever the machine is in its start state, forwardFilter skips to the
+// next position that can leave it.  Once it reaches its accepting sink every
+// later position ends a match, so the rest of input is not read.
+//------------------------------------------------------------------------------
+size_t Searcher::lastMatchEnd(const char* input, size_t from,
+   size_t length) const
+{
+   size_t lastEnd = string_view::npos;
+   int state = forward.startState();
+   if(forward.isGoalState(state))
+   {
+      lastEnd = from;
+   }
+   for(size_t pos = from; pos < length; ++pos)
+   {
+      if(state == forward.startState())
+      {
+         pos = forwardFilter.skipForward(input, pos, length);
+         if(pos == length)
+         {
+            break;
+         }
+      }
+      state = forward.nextState(state,
+         static_cast<unsigned char>(input[pos]));
+      if(forward.isAcceptState(state))
+      {
+         return length;
+      }
+      if(forward.isGoalState(state))
+      {
+         lastEnd = pos + 1;
+      }
+   }
+   return lastEnd;
+}
+
+//------------------------------------------------------------------------------
+// scanStarts(const char* input, size_t from, size_t end,
+// MarkStart markStart)
+// Runs the reverse machine backwards over input from end down to from.
+// Having read input[pos .. end - 1] it is in a goal state exactly where a
+// match starts at pos and ends at or before end.  reverseFilter skips as
+// forwardFilter does in lastMatchEnd().
+//------------------------------------------------------------------------------
+template<class MarkStart>
+void Searcher::scanStarts(const char* input, size_t from, size_t end,
+   MarkStart markStart) const
+{
+   int state = reverse.startState();
+   if(reverse.isGoalState(state))
+   {
+      markStart(end);
+   }
+   for(size_t pos = end; pos > from; --pos)
+   {
+      if(state == reverse.startState())
+      {
+         pos = reverseFilter.skipBackward(input, from, pos);
+         if(pos == from)
+         {
+            break;
+         }
+      }
+      state = reverse.nextState(state,
+         static_cast<unsigned char>(input[pos - 1]));
+      if(reverse.isGoalState(state))
+      {
+         markStart(pos - 1);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// longestMatchEnd(const char* input, size_t begin, size_t limit)
+// Runs the anchored machine from begin and returns one past the last
+// position where it was in a goal state.  Stops at the dead state or at
+// limit, past which no match ends; from the accepting sink every position
+// up to limit ends a match, so limit is returned at once.
+//------------------------------------------------------------------------------
+size_t Searcher::longestMatchEnd(const char* input, size_t begin,
+   size_t limit) const
+{
+   int state = anchored.startState();
+   size_t longestEnd = anchored.isGoalState(state) ? begin :
+      string_view::npos;
+   for(size_t pos = begin; pos < limit; ++pos)
+   {
+      state = anchored.nextState(state,
+         static_cast<unsigned char>(input[pos]));
+      if(anchored.isDecidedState(state))
+      {
+         return anchored.isAcceptState(state) ? limit : longestEnd;
+      }
+      if(anchored.isGoalState(state))
+      {
+         longestEnd = pos + 1;
+      }
+   }
+   return longestEnd;
+}
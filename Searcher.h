@@ -0,0 +1,202 @@
+//------------------------------------------------------------------------------
+// Searcher.h
+// agent
+// 17 October 2026
+// Finds the leftmost-longest matches of a FiniteStateMachine inside a
+// longer input.
+//------------------------------------------------------------------------------
+#ifndef SEARCHER_H
+#define SEARCHER_H
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "FiniteStateMachine.h"
+#include "TransitionIndex.h"
+#include "CompiledDfa.h"
+#include "CompiledNfaEpsilon.h"
+#include "Prefilter.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// Searcher Class
+// Unanchored search: reports where the language of a FiniteStateMachine (in
+// DFA or NFA-EPSILON format) occurs inside an input instead of whether the
+// whole input is in it.  Matches are leftmost-longest and do not overlap; an
+// empty match is reported at most once per position.
+// Three CompiledDfas are built, each determinized by CompiledNfaEpsilon and
+// minimized:
+//    forward  - the machine with a leading self-loop on every byte (.*R).
+//               One scan finds the end of the last match, or that there is
+//               none, without ever backing up.
+//    reverse  - the machine with every transition reversed and a leading
+//               self-loop (.*R reversed).  Scanning backwards from the last
+//               match end marks every position at which a match starts.
+//    anchored - the machine itself.  From a marked start it finds the
+//               longest match.
+// So a search costs two linear scans plus the length of the matches found,
+// rather than one anchored match per input position.
+// find() has to scan forward to the end of the input to know the last match
+// end, so a loop of find() calls, each from the end of the previous match,
+// costs O(n) per match and O(n^2) in all.  A Cursor does both scans once,
+// like findAll(), and then hands out the matches one at a time.
+// Both scans spend most of a sparse-match input in their start state, so
+// each has a Prefilter that jumps over the bytes that keep it there:
+// forwardFilter to the next byte (or required literal prefix) that can
+// begin a match, reverseFilter back to the next byte that can end one.
+// No defaul constructor, instead can only be constructed with a
+// FiniteStateMachine, CompactStateMachine, CompiledDfa or CompiledNfaEpsilon.
+// A Searcher is never modified after construction, so one instance can be
+// shared by any number of threads.
+// Public methods:
+//    find() x2
+//    findAll() x2
+// Private methods:
+//    machineOf()
+//    buildForward()
+//    buildReverse()
+//    determinize()
+//    lastMatchEnd()
+//    scanStarts()
+//    longestMatchEnd()
+// Members:
+//    forward
+//    reverse
+//    anchored
+//    forwardFilter
+//    reverseFilter
+//------------------------------------------------------------------------------
+class Searcher
+{
+   public:
+//------------------------------------------------------------------------------
+// struct Match
+// One match: input bytes start .. end - 1.  end == start for an empty match.
+//------------------------------------------------------------------------------
+      struct Match
+      {
+         size_t start;
+         size_t end;
+      };
+
+//------------------------------------------------------------------------------
+// Cursor Class
+// Iterates over the non-overlapping leftmost-longest matches of a Searcher
+// starting at or after from, in order.  The constructor runs the forward
+// scan and the backward scan once, recording every match start in a
+// bitmap, so each next() only runs the anchored machine over its own match.
+// The Searcher and the input must outlive the Cursor.
+// Public methods:
+//    next()
+// Members:
+//    searcher
+//    input
+//    from
+//    lastEnd
+//    pos
+//    starts
+//------------------------------------------------------------------------------
+      class Cursor
+      {
+         public:
+            //Constructor
+            Cursor(const Searcher& owner, string_view inputString,
+               size_t fromPos = 0)
+               : Cursor(owner, inputString.data(), inputString.size(),
+                  fromPos) {}
+
+            //Constructor
+            Cursor(const Searcher& owner, const char* inputChars,
+               size_t length, size_t fromPos = 0);
+
+            //Destructor - key word 'new' is not used.
+            ~Cursor(){}
+
+            //Fills match with the next match, false once there is none
+            bool next(Match& match);
+
+         private:
+            Cursor(); //no default constructor
+
+            const Searcher& searcher;  //Machines being searched with
+            const char* input;         //Input being searched
+            size_t from;               //Start of the search, bit 0 of starts
+            size_t lastEnd;            //Last match end, or npos if none
+            size_t pos;                //Where the next match may start
+            //Bit pos - from set for every match start pos
+            vector<uint64_t> starts;
+      };
+
+      //Constructor
+      explicit Searcher(const FiniteStateMachine& fsm)
+         : Searcher(CompactStateMachine(fsm)) {}
+
+      //Constructor from the contiguous representation
+      explicit Searcher(const CompactStateMachine& fsm);
+
+      //Constructor from a compiled DFA, which is not modified
+      explicit Searcher(const CompiledDfa& dfa) : Searcher(machineOf(dfa)) {}
+
+      //Constructor from a compiled NFA, translated to a DFA first
+      explicit Searcher(const CompiledNfaEpsilon& nfae)
+         : Searcher(nfae.translateToCompactDFA()) {}
+
+      //Destructor - key word 'new' is not used.
+      ~Searcher(){}
+
+      //Finds the leftmost-longest match starting at or after from.  Scans to
+      //the end of input; use a Cursor to step through many matches.
+      inline bool find(string_view input, size_t from, Match& match) const
+         {return find(input.data(), input.size(), from, match);}
+
+      //Finds the leftmost-longest match starting at or after from
+      bool find(const char* input, size_t length, size_t from,
+         Match& match) const;
+
+      //Returns every non-overlapping leftmost-longest match, in order
+      inline vector<Match> findAll(string_view input) const
+         {vector<Match> matches;
+          findAll(input.data(), input.size(), matches);
+          return matches;}
+
+      //Fills matches with every non-overlapping leftmost-longest match
+      void findAll(const char* input, size_t length,
+         vector<Match>& matches) const;
+
+   private:
+      Searcher(); //no default constructor
+
+      CompiledDfa forward;    //.*R, finds match ends
+      CompiledDfa reverse;    //.*R reversed, finds match starts
+      CompiledDfa anchored;   //R, finds the longest match from a start
+      Prefilter forwardFilter;   //Skips input the forward start state loops on
+      Prefilter reverseFilter;   //Skips input the reverse start state loops on
+
+      //Returns the machine whose transitions are those of dfa
+      static CompactStateMachine machineOf(const CompiledDfa& dfa);
+
+      //Builds .*R from the indexed machine
+      static CompactStateMachine buildForward(const TransitionIndex& index);
+
+      //Builds .*R reversed from the indexed machine
+      static CompactStateMachine buildReverse(const TransitionIndex& index);
+
+      //Returns the DFA format equivalent of nfae
+      static CompactStateMachine determinize(const CompactStateMachine& nfae);
+
+      //Returns one past the last match end at or after from, or npos
+      size_t lastMatchEnd(const char* input, size_t from,
+         size_t length) const;
+
+      //Calls markStart(pos) for every match start in from .. end, descending
+      template<class MarkStart>
+      void scanStarts(const char* input, size_t from, size_t end,
+         MarkStart markStart) const;
+
+      //Returns the end of the longest match starting at begin, or npos
+      size_t longestMatchEnd(const char* input, size_t begin,
+         size_t limit) const;
+};
+
+#endif // SEARCHER_H
@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+// StreamMatcher.cpp
+// agent
+// 17 October 2026
+// Implementation for StreamMatcher.h
+// Contains Implementations for:
+//    DfaStreamMatcher
+//       Constructor
+//       feed()
+//       finish()
+//       reset()
+//    NfaStreamMatcher
+//       Constructor
+//       feed()
+//       finish()
+//       reset()
+//------------------------------------------------------------------------------
+#include "StreamMatcher.h"
+
+//------------------------------------------------------------------------------
+// Constructs a DfaStreamMatcher at the start of an empty input.
+//------------------------------------------------------------------------------
+DfaStreamMatcher::DfaStreamMatcher(const CompiledDfa& compiledDfa)
+   : dfa(&compiledDfa), state(compiledDfa.startState())
+{
+}
+
+//------------------------------------------------------------------------------
+// feed(const char* input, size_t length)
+// Carries the current state over input.  Once the dead state or the
+// accepting sink is reached the remaining pieces cost nothing, and false
+// tells the caller it may stop feeding this input: finish() will return
+// false or true whatever follows.
+//------------------------------------------------------------------------------
+bool DfaStreamMatcher::feed(const char* input, size_t length)
+{
+   state = dfa->advance(state, input, length);
+   return !dfa->isDecidedState(state);
+}
+
+//------------------------------------------------------------------------------
+// finish()
+// Returns true if the current state is a goal node and starts a new input.
+//------------------------------------------------------------------------------
+bool DfaStreamMatcher::finish(void)
+{
+   bool matched = dfa->isGoalState(state);
+   reset();
+   return matched;
+}
+
+//------------------------------------------------------------------------------
+// reset()
+// Returns to the start state.
+//------------------------------------------------------------------------------
+void DfaStreamMatcher::reset(void)
+{
+   state = dfa->startState();
+}
+
+//------------------------------------------------------------------------------
+// Constructs an NfaStreamMatcher at the start of an empty input.
+//------------------------------------------------------------------------------
+NfaStreamMatcher::NfaStreamMatcher(const CompiledNfaEpsilon& compiledNfae)
+   : nfae(&compiledNfae), alive(true)
+{
+   nfae->startMatch(context);
+}
+
+//------------------------------------------------------------------------------
+// feed(const char* input, size_t length)
+// Advances the active node set over input.  Once the set has emptied the
+// remaining pieces are skipped, and false tells the caller it may stop
+// feeding this input.
+//------------------------------------------------------------------------------
+bool NfaStreamMatcher::feed(const char* input, size_t length)
+{
+   if(alive)
+   {
+      alive = nfae->advanceMatch(context, input, length);
+   }
+   return alive;
+}
+
+//------------------------------------------------------------------------------
+// finish()
+// Returns true if the active node set holds a goal node and starts a new
+// input.
+//------------------------------------------------------------------------------
+bool NfaStreamMatcher::finish(void)
+{
+   bool matched = alive && nfae->isAccepted(context);
+   reset();
+   return matched;
+}
+
+//------------------------------------------------------------------------------
+// reset()
+// Returns to the start node.
+//------------------------------------------------------------------------------
+void NfaStreamMatcher::reset(void)
+{
+   nfae->startMatch(context);
+   alive = true;
+}
@@ -0,0 +1,106 @@
+//------------------------------------------------------------------------------
+// StreamMatcher.h
+// agent
+// 17 October 2026
+// Matches an input that arrives in pieces against a CompiledDfa or a
+// CompiledNfaEpsilon
+//------------------------------------------------------------------------------
+#ifndef STREAMMATCHER_H
+#define STREAMMATCHER_H
+#include <cstddef>
+#include "CompiledDfa.h"
+#include "CompiledNfaEpsilon.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// DfaStreamMatcher Class
+// Matches one input fed through feed() in any number of pieces, of any
+// size, against a CompiledDfa.  Only the current dense state is kept between
+// pieces, so input is never buffered or copied.  finish() returns whether
+// everything fed since the last reset matched and starts the next input.
+// No defaul constructor, instead can only be constructed with the
+// CompiledDfa to match against, which must outlive the stream matcher.
+// Many stream matchers can share one CompiledDfa; each stream matcher
+// belongs to one thread at a time.
+// Public methods:
+//    feed()
+//    finish()
+//    reset()
+// Members:
+//    dfa
+//    state
+//------------------------------------------------------------------------------
+class DfaStreamMatcher
+{
+   public:
+      //Constructor
+      explicit DfaStreamMatcher(const CompiledDfa& compiledDfa);
+
+      //Destructor - key word 'new' is not used.
+      ~DfaStreamMatcher(){}
+
+      //Feeds the next piece of input, false once more input cannot change
+      //whether it matches
+      bool feed(const char* input, size_t length);
+
+      //Returns true if the input fed since reset() matches, then resets
+      bool finish(void);
+
+      //Drops any input fed so far
+      void reset(void);
+
+   private:
+      DfaStreamMatcher(); //no default constructor
+
+      const CompiledDfa* dfa;    //Automaton matched against
+      int state;                 //Dense state after the input fed so far
+};
+
+//------------------------------------------------------------------------------
+// NfaStreamMatcher Class
+// Matches one input fed through feed() in any number of pieces, of any
+// size, against a CompiledNfaEpsilon in either MatchMode.  Only the active
+// node set is kept between pieces, in a MatchContext owned by the stream
+// matcher, so input is never buffered or copied.  finish() returns whether
+// everything fed since the last reset matched and starts the next input.
+// No defaul constructor, instead can only be constructed with the
+// CompiledNfaEpsilon to match against, which must outlive the stream
+// matcher.  Many stream matchers can share one CompiledNfaEpsilon; each
+// stream matcher belongs to one thread at a time.
+// Public methods:
+//    feed()
+//    finish()
+//    reset()
+// Members:
+//    nfae
+//    context
+//    alive
+//------------------------------------------------------------------------------
+class NfaStreamMatcher
+{
+   public:
+      //Constructor
+      explicit NfaStreamMatcher(const CompiledNfaEpsilon& compiledNfae);
+
+      //Destructor - key word 'new' is not used.
+      ~NfaStreamMatcher(){}
+
+      //Feeds the next piece of input, false once it can no longer match
+      bool feed(const char* input, size_t length);
+
+      //Returns true if the input fed since reset() matches, then resets
+      bool finish(void);
+
+      //Drops any input fed so far
+      void reset(void);
+
+   private:
+      NfaStreamMatcher(); //no default constructor
+
+      const CompiledNfaEpsilon* nfae;        //Automaton matched against
+      CompiledNfaEpsilon::MatchContext context; //Active node set
+      bool alive;          //False once the active node set has emptied
+};
+
+#endif // STREAMMATCHER_H
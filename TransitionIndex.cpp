@@ -0,0 +1,300 @@
+//------------------------------------------------------------------------------
+// TransitionIndex.cpp
+// agent
+// 17 October 2026
+// Implementation for TransitionIndex.h
+// Contains implementation for:
+//    Constructor x3
+//    buildRows()
+//    buildClosures()
+//    destinations()
+//    eliminateEpsilons()
+//------------------------------------------------------------------------------
+#include "TransitionIndex.h"
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+// Renumbers the nodes of fsm densely (start node first), then builds the
+// rows from the renumbered transitions and the closures from the
+// renumbered epsilon transitions.
+// Calls:
+//    buildRows()
+//    buildClosures()
+//------------------------------------------------------------------------------
+TransitionIndex::TransitionIndex(const FiniteStateMachine& fsm)
+: nodeCount(0), start(0)
+{
+   auto indexOf = [&](int node)
+   {
+      auto found = denseIndex.emplace(node, static_cast<int>(nodeIds.size()));
+      if(found.second)
+      {
+         nodeIds.push_back(node);
+      }
+      return found.first->second;
+   };
+   indexOf(fsm.startNode);
+   for(int node : fsm.nodes)
+   {
+      indexOf(node);
+   }
+   vector<int> sources;
+   vector<char> symbols;
+   vector<int> destinations;
+   sources.reserve(fsm.transitions.size());
+   symbols.reserve(fsm.transitions.size());
+   destinations.reserve(fsm.transitions.size());
+   for(const Transition& transition : fsm.transitions)
+   {
+      if(transition.isEpsilon)
+      {
+         epsilonEdges.emplace_back(indexOf(transition.source),
+            indexOf(transition.destination));
+         continue;
+      }
+      sources.push_back(indexOf(transition.source));
+      symbols.push_back(transition.transitionChar);
+      destinations.push_back(indexOf(transition.destination));
+   }
+
+   nodeCount = static_cast<int>(nodeIds.size());
+   goals.assign(nodeCount, 0);
+   for(int node : fsm.goalNodes)
+   {
+      int dense = denseOf(node);
+      if(dense >= 0)
+      {
+         goals[dense] = 1;
+      }
+   }
+   buildRows(sources.size(), sources.data(), symbols.data(),
+      destinations.data());
+   buildClosures();
+}
+
+//------------------------------------------------------------------------------
+// Indexes a CompactStateMachine in place: its node ids are already dense, so
+// neither denseIndex nor nodeIds is filled and the rows are built straight
+// from its transition arrays, the closures from its epsilon arrays.  An
+// empty machine, as left by the default constructor or a move, is indexed
+// as a single start node with no edges that is not a goal, so it matches
+// nothing instead of leaving the index without a start node.
+// Calls:
+//    buildRows()
+//    buildClosures()
+//------------------------------------------------------------------------------
+TransitionIndex::TransitionIndex(const CompactStateMachine& fsm)
+: nodeCount(max(fsm.nodeCount(), 1)),
+  start(fsm.nodeCount() > 0 ? fsm.startNode() : 0)
+{
+   goals.assign(nodeCount, 0);
+   for(int dense = 0; dense < fsm.nodeCount(); ++dense)
+   {
+      goals[dense] = fsm.isGoal(dense) ? 1 : 0;
+   }
+   buildRows(fsm.transitionCount(), fsm.sources().data(),
+      fsm.symbols().data(), fsm.destinations().data());
+   epsilonEdges.reserve(fsm.epsilonCount());
+   for(size_t epsilon = 0; epsilon < fsm.epsilonCount(); ++epsilon)
+   {
+      epsilonEdges.emplace_back(fsm.epsilonSources()[epsilon],
+         fsm.epsilonDestinations()[epsilon]);
+   }
+   buildClosures();
+}
+
+//------------------------------------------------------------------------------
+// Indexes a CompactStateMachine that is not needed afterwards: once the rows
+// and the epsilon edges are copied out of fsm it is emptied, so its arrays
+// are freed before the closures are built.  An empty machine is indexed as
+// by the constructor above.
+// Calls:
+//    buildRows()
+//    buildClosures()
+//------------------------------------------------------------------------------
+TransitionIndex::TransitionIndex(CompactStateMachine&& fsm)
+: nodeCount(max(fsm.nodeCount(), 1)),
+  start(fsm.nodeCount() > 0 ? fsm.startNode() : 0)
+{
+   CompactStateMachine machine(move(fsm));
+   goals.assign(nodeCount, 0);
+   for(int dense = 0; dense < machine.nodeCount(); ++dense)
+   {
+      goals[dense] = machine.isGoal(dense) ? 1 : 0;
+   }
+   buildRows(machine.transitionCount(), machine.sources().data(),
+      machine.symbols().data(), machine.destinations().data());
+   epsilonEdges.reserve(machine.epsilonCount());
+   for(size_t epsilon = 0; epsilon < machine.epsilonCount(); ++epsilon)
+   {
+      epsilonEdges.emplace_back(machine.epsilonSources()[epsilon],
+         machine.epsilonDestinations()[epsilon]);
+   }
+   machine = CompactStateMachine();
+   buildClosures();
+}
+
+//------------------------------------------------------------------------------
+// buildRows(size_t count, const int* sources, const char* symbols,
+// const int* destinations)
+// Counting-sorts the transitions into CSR rows by source and orders each
+// row by symbol.  Both sorts are stable, so the transitions of a node on
+// one symbol keep the order they were given in; DfaMinimizer relies on
+// that to let the first of duplicate transitions win, as CompiledDfa does.
+//------------------------------------------------------------------------------
+void TransitionIndex::buildRows(size_t count, const int* sources,
+   const char* symbols, const int* destinations)
+{
+   rowOffsets.assign(nodeCount + 1, 0);
+   for(size_t transition = 0; transition < count; ++transition)
+   {
+      ++rowOffsets[sources[transition] + 1];
+   }
+   for(int dense = 0; dense < nodeCount; ++dense)
+   {
+      rowOffsets[dense + 1] += rowOffsets[dense];
+   }
+   vector<pair<unsigned char, int>> edges(count);
+   vector<int> fill(rowOffsets.begin(), rowOffsets.end() - 1);
+   for(size_t transition = 0; transition < count; ++transition)
+   {
+      edges[fill[sources[transition]]++] =
+         make_pair(static_cast<unsigned char>(symbols[transition]),
+            destinations[transition]);
+   }
+   edgeSymbols.reserve(edges.size());
+   edgeDestinations.reserve(edges.size());
+   for(int dense = 0; dense < nodeCount; ++dense)
+   {
+      stable_sort(edges.begin() + rowOffsets[dense],
+         edges.begin() + rowOffsets[dense + 1],
+         [](const pair<unsigned char, int>& a,
+            const pair<unsigned char, int>& b) {return a.first < b.first;});
+      for(int edge = rowOffsets[dense]; edge < rowOffsets[dense + 1]; ++edge)
+      {
+         edgeSymbols.push_back(edges[edge].first);
+         edgeDestinations.push_back(edges[edge].second);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// buildClosures()
+// Sorts epsilonEdges by source, so the epsilon edges of a node are
+// contiguous, then computes every epsilon closure with one depth first
+// search per node over them.
+//------------------------------------------------------------------------------
+void TransitionIndex::buildClosures(void)
+{
+   sort(epsilonEdges.begin(), epsilonEdges.end());
+   vector<int> epsilonOffsets(nodeCount + 1, 0);
+   for(const pair<int, int>& epsilon : epsilonEdges)
+   {
+      ++epsilonOffsets[epsilon.first + 1];
+   }
+   for(int dense = 0; dense < nodeCount; ++dense)
+   {
+      epsilonOffsets[dense + 1] += epsilonOffsets[dense];
+   }
+
+   vector<int> seenBy(nodeCount, -1);
+   vector<int> pending;
+   closureOffsets.assign(1, 0);
+   for(int dense = 0; dense < nodeCount; ++dense)
+   {
+      seenBy[dense] = dense;
+      closureNodes.push_back(dense);
+      pending.assign(1, dense);
+      while(!pending.empty())
+      {
+         int cur = pending.back();
+         pending.pop_back();
+         for(int edge = epsilonOffsets[cur]; edge < epsilonOffsets[cur + 1];
+            ++edge)
+         {
+            int next = epsilonEdges[edge].second;
+            if(seenBy[next] != dense)
+            {
+               seenBy[next] = dense;
+               closureNodes.push_back(next);
+               pending.push_back(next);
+            }
+         }
+      }
+      closureOffsets.push_back(static_cast<int>(closureNodes.size()));
+   }
+   vector<pair<int, int>>().swap(epsilonEdges);
+}
+
+//------------------------------------------------------------------------------
+// destinations(int dense, char symbol)
+// Binary searches the row of dense for the edges labelled symbol.
+//------------------------------------------------------------------------------
+TransitionIndex::NodeRange TransitionIndex::destinations(int dense,
+   char symbol) const
+{
+   unsigned char key = static_cast<unsigned char>(symbol);
+   auto rowBegin = edgeSymbols.begin() + rowOffsets[dense];
+   auto rowEnd = edgeSymbols.begin() + rowOffsets[dense + 1];
+   auto range = equal_range(rowBegin, rowEnd, key);
+   const int* base = edgeDestinations.data();
+   return NodeRange(base + (range.first - edgeSymbols.begin()),
+      base + (range.second - edgeSymbols.begin()));
+}
+
+//------------------------------------------------------------------------------
+// eliminateEpsilons()
+// Node n of the result reads, on every symbol, what any node of the
+// epsilon closure of n reads, and is a goal node if its closure holds one,
+// so it matches exactly the strings the closure matched.  Nodes are added
+// breadth first from the start node, which becomes node 0; nodes that were
+// only entered by epsilon transitions are no longer reached and are left
+// out.  The edges of each node are sorted and duplicates dropped.
+//------------------------------------------------------------------------------
+CompactStateMachine TransitionIndex::eliminateEpsilons(void) const
+{
+   CompactStateMachine result;
+   if(nodeCount == 0)
+   {
+      return result;
+   }
+   vector<int> newId(nodeCount, -1);
+   vector<int> order(1, start);
+   newId[start] = result.addNode();
+   result.setStartNode(newId[start]);
+   vector<pair<unsigned char, int>> edges;
+   for(size_t next = 0; next < order.size(); ++next)
+   {
+      int node = order[next];
+      edges.clear();
+      bool goal = false;
+      NodeRange members = epsilonClosure(node);
+      for(const int* member = members.first; member != members.second;
+         ++member)
+      {
+         goal = goal || goals[*member];
+         for(int edge = rowOffsets[*member]; edge < rowOffsets[*member + 1];
+            ++edge)
+         {
+            edges.emplace_back(edgeSymbols[edge], edgeDestinations[edge]);
+         }
+      }
+      if(goal)
+      {
+         result.setGoal(newId[node]);
+      }
+      sort(edges.begin(), edges.end());
+      edges.erase(unique(edges.begin(), edges.end()), edges.end());
+      for(const pair<unsigned char, int>& edge : edges)
+      {
+         if(newId[edge.second] < 0)
+         {
+            newId[edge.second] = result.addNode();
+            order.push_back(edge.second);
+         }
+         result.addTransition(newId[node], static_cast<char>(edge.first),
+            newId[edge.second]);
+      }
+   }
+   return result;
+}
@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------------
+// TransitionIndex.h
+// agent
+// 17 October 2026
+// Compressed adjacency index over the transitions of a FiniteStateMachine
+//------------------------------------------------------------------------------
+#ifndef TRANSITIONINDEX_H
+#define TRANSITIONINDEX_H
+#include <unordered_map>
+#include <vector>
+#include <utility>
+#include "FiniteStateMachine.h"
+#include "CompactStateMachine.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// TransitionIndex Class
+// Built once from a FiniteStateMachine so that transition and epsilon
+// closure lookups cost O(out-degree) instead of a scan of the whole
+// transition list.  Nodes are renumbered densely 0 .. size() - 1; every
+// method other than denseOf() works in dense numbering.  The nodes of a
+// CompactStateMachine are dense already and keep their ids, so no node map
+// is built for one.
+// Transitions are stored in compressed sparse row (CSR) form: the edges of
+// dense node n are edgeSymbols/edgeDestinations[rowOffsets[n] ..
+// rowOffsets[n + 1] - 1], sorted by unsigned symbol.  Epsilon transitions
+// are not edges; they only feed the epsilon closure of every node, which is
+// computed at construction and stored the same way.
+// eliminateEpsilons() folds the closures into the edges and goal flags, so
+// engines built from its result never take a closure while matching.
+// Public methods:
+//    size()
+//    denseOf()
+//    nodeOf()
+//    startNode()
+//    isGoal()
+//    destinations()
+//    epsilonClosure()
+//    hasEpsilons()
+//    eliminateEpsilons()
+//    edgesBegin()
+//    edgesEnd()
+//    edgeSymbol()
+//    edgeDestination()
+// Private methods:
+//    buildRows()
+//    buildClosures()
+// Members:
+//    denseIndex
+//    nodeIds
+//    nodeCount
+//    start
+//    goals
+//    rowOffsets
+//    edgeSymbols
+//    edgeDestinations
+//    epsilonEdges
+//    closureOffsets
+//    closureNodes
+//------------------------------------------------------------------------------
+class TransitionIndex
+{
+   public:
+      //Range of dense node numbers
+      typedef pair<const int*, const int*> NodeRange;
+
+      //Empty index
+      TransitionIndex() : nodeCount(0), start(-1) {}
+
+      //Indexes fsm
+      explicit TransitionIndex(const FiniteStateMachine& fsm);
+
+      //Indexes fsm, whose node ids are used as dense numbers
+      explicit TransitionIndex(const CompactStateMachine& fsm);
+
+      //Indexes fsm like the constructor above, releasing fsm's arrays once
+      //they are read
+      explicit TransitionIndex(CompactStateMachine&& fsm);
+
+      //Number of dense nodes
+      inline int size(void) const {return nodeCount;}
+
+      //Dense number of node, or -1 if node is not in the machine
+      inline int denseOf(int node) const
+         {if(nodeIds.empty()) {return (node >= 0 && node < nodeCount) ?
+             node : -1;}
+          auto found = denseIndex.find(node);
+          return (found == denseIndex.end()) ? -1 : found->second;}
+
+      //Original node id of a dense node
+      inline int nodeOf(int dense) const
+         {return nodeIds.empty() ? dense : nodeIds[dense];}
+
+      //Dense number of the start node
+      inline int startNode(void) const {return start;}
+
+      //Returns true if the dense node is a goal node
+      inline bool isGoal(int dense) const {return goals[dense] != 0;}
+
+      //Dense destinations of dense node on symbol
+      NodeRange destinations(int dense, char symbol) const;
+
+      //Dense nodes reachable from dense node on EPSILON, including itself
+      inline NodeRange epsilonClosure(int dense) const
+         {return NodeRange(closureNodes.data() + closureOffsets[dense],
+            closureNodes.data() + closureOffsets[dense + 1]);}
+
+      //Returns true if some epsilon closure holds more than its own node
+      inline bool hasEpsilons(void) const
+         {return static_cast<int>(closureNodes.size()) > nodeCount;}
+
+      //Machine without epsilon transitions that matches the same strings
+      CompactStateMachine eliminateEpsilons(void) const;
+
+      //Edge positions of a dense node, for walking every edge in order
+      inline int edgesBegin(int dense) const {return rowOffsets[dense];}
+      inline int edgesEnd(int dense) const {return rowOffsets[dense + 1];}
+      inline char edgeSymbol(int edge) const
+         {return static_cast<char>(edgeSymbols[edge]);}
+      inline int edgeDestination(int edge) const
+         {return edgeDestinations[edge];}
+
+   private:
+      unordered_map<int, int> denseIndex;    //node id -> dense number
+      vector<int> nodeIds;                   //dense number -> node id
+      int nodeCount;                         //Number of dense nodes
+      int start;                             //Dense start node
+      vector<char> goals;                    //Goal flag per dense node
+      vector<int> rowOffsets;                //CSR row starts, size() + 1
+      vector<unsigned char> edgeSymbols;     //Edge symbols by row
+      vector<int> edgeDestinations;          //Dense edge destinations by row
+      vector<pair<int, int>> epsilonEdges;   //Dense epsilon source, dest
+      vector<int> closureOffsets;            //Closure row starts, size() + 1
+      vector<int> closureNodes;              //Dense closure members by row
+
+      //Fills the CSR rows from count dense transitions
+      void buildRows(size_t count, const int* sources, const char* symbols,
+         const int* destinations);
+
+      //Computes the epsilon closure of every dense node from epsilonEdges,
+      //which it then releases
+      void buildClosures(void);
+};
+
+#endif // TRANSITIONINDEX_H
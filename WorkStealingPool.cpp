@@ -0,0 +1,183 @@
+//------------------------------------------------------------------------------
+// WorkStealingPool.cpp
+// agent
+// 17 October 2026
+// Implementation for WorkStealingPool.h
+// Contains implementation for:
+//    Constructor
+//    Destructor
+//    parallelFor()
+//    popTask()
+//    runTask()
+//    workerLoop()
+//------------------------------------------------------------------------------
+#include "WorkStealingPool.h"
+
+//------------------------------------------------------------------------------
+// Creates one deque per worker before starting any thread, so every worker
+// can steal from every deque from the start.
+//------------------------------------------------------------------------------
+WorkStealingPool::WorkStealingPool(unsigned threadCount)
+: queuedTasks(0), stopping(false)
+{
+   if(threadCount == 0)
+   {
+      threadCount = thread::hardware_concurrency();
+   }
+   if(threadCount == 0)
+   {
+      threadCount = 1;
+   }
+   for(unsigned i = 0; i < threadCount; ++i)
+   {
+      queues.push_back(make_unique<WorkQueue>());
+   }
+   for(unsigned i = 0; i < threadCount; ++i)
+   {
+      workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+   }
+}
+
+//------------------------------------------------------------------------------
+// Wakes every worker with stopping set and joins them.
+//------------------------------------------------------------------------------
+WorkStealingPool::~WorkStealingPool()
+{
+   {
+      lock_guard<mutex> guard(sleepLock);
+      stopping = true;
+   }
+   wakeUp.notify_all();
+   for(thread& worker : workers)
+   {
+      worker.join();
+   }
+}
+
+//------------------------------------------------------------------------------
+// parallelFor(size_t count, size_t grain, const RangeBody& body)
+// Cuts [0, count) into chunks of grain items, deals them round robin onto
+// the worker deques and wakes the workers.  The calling thread then steals
+// chunks itself until none are queued and finally waits for chunks still
+// running on workers.
+// Calls:
+//    popTask()
+//    runTask()
+//------------------------------------------------------------------------------
+void WorkStealingPool::parallelFor(size_t count, size_t grain,
+   const RangeBody& body)
+{
+   if(count == 0)
+   {
+      return;
+   }
+   if(grain == 0)
+   {
+      grain = 1;
+   }
+   Batch batch;
+   batch.body = &body;
+   batch.remaining = (count + grain - 1) / grain;
+
+   size_t chunk = 0;
+   for(size_t begin = 0; begin < count; begin += grain, ++chunk)
+   {
+      Task task = {&batch, begin, (count - begin < grain) ? count : begin + grain};
+      WorkQueue& queue = *queues[chunk % queues.size()];
+      lock_guard<mutex> guard(queue.lock);
+      queue.tasks.push_back(task);
+      ++queuedTasks;
+   }
+   {
+      lock_guard<mutex> guard(sleepLock);
+   }
+   wakeUp.notify_all();
+
+   Task task;
+   while(batch.remaining > 0 && popTask(queues.size(), task))
+   {
+      runTask(task);
+   }
+   unique_lock<mutex> guard(batch.doneLock);
+   batch.done.wait(guard, [&batch]{return batch.remaining == 0;});
+}
+
+//------------------------------------------------------------------------------
+// popTask(size_t self, Task& task)
+// Takes the newest task from deque self, or steals the oldest task from the
+// other deques in turn.  self == queues.size() (the calling thread of
+// parallelFor()) only steals.  Returns false if every deque was empty.
+//------------------------------------------------------------------------------
+bool WorkStealingPool::popTask(size_t self, Task& task)
+{
+   size_t queueCount = queues.size();
+   if(self < queueCount)
+   {
+      WorkQueue& own = *queues[self];
+      lock_guard<mutex> guard(own.lock);
+      if(!own.tasks.empty())
+      {
+         task = own.tasks.back();
+         own.tasks.pop_back();
+         --queuedTasks;
+         return true;
+      }
+   }
+   for(size_t i = 1; i <= queueCount; ++i)
+   {
+      WorkQueue& victim = *queues[(self + i) % queueCount];
+      lock_guard<mutex> guard(victim.lock);
+      if(!victim.tasks.empty())
+      {
+         task = victim.tasks.front();
+         victim.tasks.pop_front();
+         --queuedTasks;
+         return true;
+      }
+   }
+   return false;
+}
+
+//------------------------------------------------------------------------------
+// runTask(const Task& task)
+// Calls the batch body on the task range; the thread finishing the last
+// chunk wakes the thread waiting in parallelFor().  remaining is decremented
+// under doneLock so the batch cannot be destroyed by the waiting thread
+// before it is signalled.
+//------------------------------------------------------------------------------
+void WorkStealingPool::runTask(const Task& task)
+{
+   Batch* batch = task.batch;
+   (*batch->body)(task.begin, task.end);
+   lock_guard<mutex> guard(batch->doneLock);
+   if(--batch->remaining == 0)
+   {
+      batch->done.notify_all();
+   }
+}
+
+//------------------------------------------------------------------------------
+// workerLoop(size_t self)
+// Runs tasks while any are queued, sleeps on wakeUp otherwise.
+// Calls:
+//    popTask()
+//    runTask()
+//------------------------------------------------------------------------------
+void WorkStealingPool::workerLoop(size_t self)
+{
+   Task task;
+   while(true)
+   {
+      if(popTask(self, task))
+      {
+         runTask(task);
+         continue;
+      }
+      unique_lock<mutex> guard(sleepLock);
+      wakeUp.wait(guard, [this]{return stopping || queuedTasks > 0;});
+      if(stopping && queuedTasks == 0)
+      {
+         return;
+      }
+   }
+}
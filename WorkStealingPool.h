@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------------
+// WorkStealingPool.h
+// agent
+// 17 October 2026
+// Fixed set of worker threads that share ranges of work by stealing
+//------------------------------------------------------------------------------
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// WorkStealingPool Class
+// Runs parallelFor() ranges on a fixed set of worker threads.  Each worker
+// owns a deque of tasks; it takes work from the back of its own deque and,
+// when that is empty, steals from the front of the others, so a worker that
+// drew short inputs keeps busy on another worker's backlog.  The thread
+// calling parallelFor() steals too until its range is finished.
+// Public methods:
+//    size()
+//    parallelFor()
+// Private methods:
+//    popTask()
+//    runTask()
+//    workerLoop()
+// Members:
+//    queues
+//    workers
+//    sleepLock
+//    wakeUp
+//    queuedTasks
+//    stopping
+//------------------------------------------------------------------------------
+class WorkStealingPool
+{
+   public:
+      //Body of a parallelFor(), called with a half open range [begin, end)
+      typedef function<void(size_t, size_t)> RangeBody;
+
+      //Starts threadCount workers, or one per hardware thread if 0
+      explicit WorkStealingPool(unsigned threadCount = 0);
+
+      //Stops and joins every worker
+      ~WorkStealingPool();
+
+      //Number of worker threads
+      inline unsigned size(void) const
+         {return static_cast<unsigned>(workers.size());}
+
+      //Calls body over [0, count) in chunks of grain, returns when done
+      void parallelFor(size_t count, size_t grain, const RangeBody& body);
+
+   private:
+      WorkStealingPool(const WorkStealingPool&);            //not copyable
+      WorkStealingPool& operator=(const WorkStealingPool&); //not copyable
+
+//------------------------------------------------------------------------------
+// struct Batch
+// One parallelFor() call: its body and the number of chunks not yet done.
+// done is signalled under doneLock when remaining drops to 0.
+//------------------------------------------------------------------------------
+      struct Batch
+      {
+         const RangeBody* body;
+         atomic<size_t> remaining;
+         mutex doneLock;
+         condition_variable done;
+      };
+
+//------------------------------------------------------------------------------
+// struct Task
+// One chunk [begin, end) of a Batch.
+//------------------------------------------------------------------------------
+      struct Task
+      {
+         Batch* batch;
+         size_t begin;
+         size_t end;
+      };
+
+//------------------------------------------------------------------------------
+// struct WorkQueue
+// Deque of Tasks owned by one worker, guarded by lock.
+//------------------------------------------------------------------------------
+      struct WorkQueue
+      {
+         mutex lock;
+         deque<Task> tasks;
+      };
+
+      vector<unique_ptr<WorkQueue>> queues;  //One deque per worker
+      vector<thread> workers;                //Worker threads
+      mutex sleepLock;                       //Guards sleeping workers
+      condition_variable wakeUp;             //Signalled when work arrives
+      atomic<size_t> queuedTasks;            //Tasks in all deques
+      bool stopping;                         //Set by the destructor
+
+      //Takes a task, own deque first (back), then steals (front)
+      bool popTask(size_t self, Task& task);
+
+      //Runs task and signals its batch when it was the last chunk
+      void runTask(const Task& task);
+
+      //Body of each worker thread
+      void workerLoop(size_t self);
+};
+
+#endif // WORKSTEALINGPOOL_H
@@ -26,9 +26,9 @@ int main()
    nfaeRegEx.nodes = {0, 1, 2, 3, 4, 5, 6};
    nfaeRegEx.startNode = 0;
    nfaeRegEx.goalNodes = {1, 2, 4, 5, 6};
-   nfaeRegEx.transitions.emplace_back(0, '\x0', 1);
-   nfaeRegEx.transitions.emplace_back(0, '\x0', 3);
-   nfaeRegEx.transitions.emplace_back(0, '\x0', 5);
+   nfaeRegEx.transitions.emplace_back(0, EPSILON, 1);
+   nfaeRegEx.transitions.emplace_back(0, EPSILON, 3);
+   nfaeRegEx.transitions.emplace_back(0, EPSILON, 5);
    nfaeRegEx.transitions.emplace_back(1, 'a', 2);
    nfaeRegEx.transitions.emplace_back(2, 'b', 2);
    nfaeRegEx.transitions.emplace_back(3, 'b', 3);